@@ -0,0 +1,187 @@
+/**
+ * @file Arduino.cpp
+ * @brief Host clock, Print/Stream helpers and Serial
+ */
+
+#include "Arduino.h"
+
+#include <chrono>
+
+HostSerial Serial;
+
+/*===========================================================================*/
+/*  CLOCK                                                                    */
+/*===========================================================================*/
+
+static bool hostFrozen = false;
+static uint64_t hostFrozenUs = 0;
+static int64_t hostOffsetUs = 0; // real time -> clock time
+
+static uint64_t hostRealUs()
+{
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+
+static uint64_t hostNowUs()
+{
+    return hostFrozen ? hostFrozenUs : hostRealUs() + hostOffsetUs;
+}
+
+uint32_t millis()
+{
+    return (uint32_t)(hostNowUs() / 1000);
+}
+
+uint32_t micros()
+{
+    return (uint32_t)hostNowUs();
+}
+
+void delay(uint32_t ms)
+{
+    // Nothing on the host needs the wait itself, only the time passing
+    if (hostFrozen)
+    {
+        hostFrozenUs += (uint64_t)ms * 1000;
+    }
+    else
+    {
+        hostOffsetUs += (int64_t)ms * 1000;
+    }
+}
+
+void hostClockFreeze(uint32_t ms)
+{
+    hostFrozen = true;
+    hostFrozenUs = (uint64_t)ms * 1000;
+}
+
+void hostClockAdvance(uint32_t ms)
+{
+    if (hostFrozen)
+    {
+        hostFrozenUs += (uint64_t)ms * 1000;
+    }
+}
+
+void hostClockRun()
+{
+    if (hostFrozen)
+    {
+        hostOffsetUs = (int64_t)hostFrozenUs - (int64_t)hostRealUs();
+        hostFrozen = false;
+    }
+}
+
+/*===========================================================================*/
+/*  PRINT & STREAM                                                           */
+/*===========================================================================*/
+
+size_t Print::write(const uint8_t *data, size_t len)
+{
+    size_t n = 0;
+    while (n < len && write(data[n]))
+    {
+        n++;
+    }
+    return n;
+}
+
+size_t Print::print(const char *text)
+{
+    return write((const uint8_t *)text, strlen(text));
+}
+
+size_t Print::println(const char *text)
+{
+    return print(text) + print("\r\n");
+}
+
+size_t Print::printf(const char *format, ...)
+{
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    if (len < 0)
+        return 0;
+    return write((const uint8_t *)line, (size_t)len < sizeof(line) ? len : sizeof(line) - 1);
+}
+
+size_t Stream::readBytes(uint8_t *data, size_t len)
+{
+    size_t n = 0;
+    while (n < len && available() > 0)
+    {
+        data[n++] = (uint8_t)read();
+    }
+    return n;
+}
+
+size_t HostSerial::write(uint8_t byte)
+{
+    return fputc(byte, stdout) == EOF ? 0 : 1;
+}
+
+size_t HostSerial::write(const uint8_t *data, size_t len)
+{
+    return fwrite(data, 1, len, stdout);
+}
+
+void HostStream::setInput(const uint8_t *data, size_t len, size_t chunk)
+{
+    _data = data;
+    _len = data ? len : 0;
+    _pos = 0;
+    _chunk = chunk ? chunk : 1;
+}
+
+int HostStream::available()
+{
+    size_t left = _len - _pos;
+    return (int)(left < _chunk ? left : _chunk);
+}
+
+int HostStream::read()
+{
+    return _pos < _len ? _data[_pos++] : -1;
+}
+
+int HostStream::peek()
+{
+    return _pos < _len ? _data[_pos] : -1;
+}
+
+size_t HostStream::readBytes(uint8_t *data, size_t len)
+{
+    size_t left = _len - _pos;
+    size_t n = len < left ? len : left;
+    memcpy(data, _data + _pos, n);
+    _pos += n;
+    return n;
+}
+
+size_t HostStream::write(uint8_t byte)
+{
+    return write(&byte, 1);
+}
+
+size_t HostStream::write(const uint8_t *data, size_t len)
+{
+    // Keep the most recent bytes, a status or subscription frame fits
+    for (size_t i = 0; i < len; i++)
+    {
+        if (_outLen == sizeof(_out))
+        {
+            memmove(_out, _out + 1, sizeof(_out) - 1);
+            _outLen--;
+        }
+        _out[_outLen++] = data[i];
+    }
+    written += len;
+    return len;
+}
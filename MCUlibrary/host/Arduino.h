@@ -0,0 +1,144 @@
+/**
+ * @file Arduino.h
+ * @brief Minimal Arduino core for building the libraries on a workstation
+ *
+ * Only what lib/HWMonitor, lib/HWDisplay and the benchmarks use: Print,
+ * Stream, Serial on stdout, millis()/micros()/delay() and the PROGMEM
+ * macros. The clock runs in real time until hostClockFreeze(); after that
+ * it only moves with hostClockAdvance() and delay(), so timeouts and
+ * rate limits can be driven step by step. delay() never blocks, it moves
+ * the clock forward in either mode.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+/*===========================================================================*/
+/*  PROGRAM MEMORY                                                           */
+/*===========================================================================*/
+
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+
+/*===========================================================================*/
+/*  CLOCK                                                                    */
+/*===========================================================================*/
+
+uint32_t millis();
+uint32_t micros();
+
+/**
+ * @brief Advance the clock without sleeping
+ */
+void delay(uint32_t ms);
+
+/**
+ * @brief Stop the clock at the given time
+ */
+void hostClockFreeze(uint32_t ms = 0);
+
+/**
+ * @brief Move a frozen clock forward, no effect in real time
+ */
+void hostClockAdvance(uint32_t ms);
+
+/**
+ * @brief Back to real time, continuing from the current reading
+ */
+void hostClockRun();
+
+/*===========================================================================*/
+/*  STREAMS                                                                  */
+/*===========================================================================*/
+
+class Print
+{
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t byte) = 0;
+    virtual size_t write(const uint8_t *data, size_t len);
+
+    size_t print(const char *text);
+    size_t println(const char *text = "");
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    virtual size_t readBytes(uint8_t *data, size_t len);
+    size_t readBytes(char *data, size_t len) { return readBytes((uint8_t *)data, len); }
+};
+
+/**
+ * @brief Serial on stdout, nothing to read
+ */
+class HostSerial : public Stream
+{
+public:
+    void begin(unsigned long baud) { (void)baud; }
+
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+    size_t write(uint8_t byte) override;
+    size_t write(const uint8_t *data, size_t len) override;
+
+    explicit operator bool() const { return true; }
+};
+
+/**
+ * @brief Stream over caller-owned memory
+ *
+ * Reads return the bytes passed to setInput(), at most `chunk` per
+ * available() so update() sees them arrive in pieces as from a UART.
+ * Writes (ACK, SUBSCRIBE frames) are counted and the last ones kept.
+ */
+class HostStream : public Stream
+{
+public:
+    HostStream() : written(0), _data(nullptr), _len(0), _pos(0), _chunk(64), _outLen(0) {}
+
+    void setInput(const uint8_t *data, size_t len, size_t chunk = 64);
+    size_t remaining() const { return _len - _pos; }
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t readBytes(uint8_t *data, size_t len) override;
+
+    size_t write(uint8_t byte) override;
+    size_t write(const uint8_t *data, size_t len) override;
+
+    /** @brief Tail of the written bytes, up to sizeof(_out) */
+    const uint8_t *output() const { return _out; }
+    size_t outputLen() const { return _outLen; }
+
+    uint32_t written;
+
+private:
+    const uint8_t *_data;
+    size_t _len;
+    size_t _pos;
+    size_t _chunk;
+    uint8_t _out[64];
+    size_t _outLen;
+};
+
+extern HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,278 @@
+/**
+ * @file frame_test.cpp
+ * @brief Frames with more sensors than the instance stores
+ *
+ * The host sends every sensor it knows about. A monitor sized for the few
+ * a sketch reads must still accept those frames and keep the first
+ * MaxSensors, whichever entry point parses them.
+ *
+ * Usage: frame_test   (exit status 1 if any check fails)
+ */
+
+#include <Arduino.h>
+#include "HWMonitor.h"
+
+#include <stdio.h>
+#include <vector>
+
+#define TEST_SENSORS 100
+
+typedef std::vector<uint8_t> Bytes;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                          \
+    do                                                                       \
+    {                                                                        \
+        if (!(cond))                                                         \
+        {                                                                    \
+            printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+            failures++;                                                      \
+        }                                                                    \
+    } while (0)
+
+/*===========================================================================*/
+/*  FRAMES                                                                   */
+/*===========================================================================*/
+
+static HWSensorId testId(uint8_t index)
+{
+    return 0x0100 + index;
+}
+
+static float testValue(uint8_t index)
+{
+    return 10.0f + index;
+}
+
+static void pushFloat(Bytes &out, float value)
+{
+    uint8_t bytes[4];
+    memcpy(bytes, &value, 4);
+    out.insert(out.end(), bytes, bytes + 4);
+}
+
+static void pushId(Bytes &out, HWSensorId id)
+{
+    out.push_back(id >> 8);
+    out.push_back(id & 0xFF);
+}
+
+// START, VERSION and for v3 TYPE and SEQ; COUNT is left to the caller
+static void beginFrame(Bytes &out, uint8_t version, uint8_t type = 0, uint8_t seq = 0)
+{
+    out.push_back(HW_PROTO_START);
+    out.push_back(version);
+    if (version == HW_PROTO_VERSION_V3)
+    {
+        out.push_back(type);
+        out.push_back(seq);
+    }
+}
+
+static void endFrame(Bytes &out, size_t start)
+{
+    uint16_t crc = hwCrc16(out.data() + start + 1, out.size() - start - 1);
+    out.push_back(crc & 0xFF);
+    out.push_back(crc >> 8);
+    out.push_back(HW_PROTO_END);
+}
+
+static void appendKeyframe(Bytes &out, uint8_t version)
+{
+    size_t start = out.size();
+    beginFrame(out, version, HW_FRAME_KEYFRAME | HW_ENC_FLOAT32);
+    out.push_back(TEST_SENSORS);
+    for (uint8_t i = 0; i < TEST_SENSORS; i++)
+    {
+        pushId(out, testId(i));
+        pushFloat(out, testValue(i));
+    }
+    endFrame(out, start);
+}
+
+// SCHEMA then VALUES, both with every test sensor
+static void appendSchemaValues(Bytes &out)
+{
+    size_t start = out.size();
+    beginFrame(out, HW_PROTO_VERSION_V3, HW_FRAME_SCHEMA, 1);
+    out.push_back(TEST_SENSORS);
+    for (uint8_t i = 0; i < TEST_SENSORS; i++)
+    {
+        pushId(out, testId(i));
+    }
+    endFrame(out, start);
+
+    Bytes ids;
+    for (uint8_t i = 0; i < TEST_SENSORS; i++)
+    {
+        pushId(ids, testId(i));
+    }
+    uint16_t hash = hwCrc16(ids.data(), ids.size());
+
+    start = out.size();
+    beginFrame(out, HW_PROTO_VERSION_V3, HW_FRAME_VALUES | HW_ENC_FLOAT32, 2);
+    out.push_back(hash & 0xFF);
+    out.push_back(hash >> 8);
+    out.push_back(TEST_SENSORS);
+    for (uint8_t i = 0; i < TEST_SENSORS; i++)
+    {
+        pushFloat(out, testValue(i));
+    }
+    endFrame(out, start);
+}
+
+// A full SCALE chunk, then every test sensor as int16 with scale 0.5
+static void appendScaled(Bytes &out)
+{
+    size_t start = out.size();
+    beginFrame(out, HW_PROTO_VERSION_V3, HW_FRAME_SCALE, 1);
+    out.push_back(HW_SCALE_RECORDS);
+    for (uint8_t i = 0; i < HW_SCALE_RECORDS; i++)
+    {
+        pushId(out, testId(i));
+        pushFloat(out, 0.5f);
+        pushFloat(out, 0.0f);
+    }
+    endFrame(out, start);
+
+    start = out.size();
+    beginFrame(out, HW_PROTO_VERSION_V3, HW_FRAME_KEYFRAME | HW_ENC_INT16, 2);
+    out.push_back(TEST_SENSORS);
+    for (uint8_t i = 0; i < TEST_SENSORS; i++)
+    {
+        int16_t raw = (int16_t)(testValue(i) * 2);
+        pushId(out, testId(i));
+        out.push_back(raw & 0xFF);
+        out.push_back((uint16_t)raw >> 8);
+    }
+    endFrame(out, start);
+}
+
+/*===========================================================================*/
+/*  CHECKS                                                                   */
+/*===========================================================================*/
+
+enum Entry
+{
+    ENTRY_BYTES,
+    ENTRY_FEED,
+    ENTRY_PARSE
+};
+
+static const char *const entryNames[] = {"processByte", "feed", "parseFrames"};
+
+template <typename Monitor>
+static void run(Monitor &monitor, const Bytes &stream, Entry entry)
+{
+    switch (entry)
+    {
+    case ENTRY_BYTES:
+        for (size_t i = 0; i < stream.size(); i++)
+        {
+            monitor.processByte(stream[i]);
+        }
+        break;
+    case ENTRY_FEED:
+        // Chunks as update() reads them, so records split across calls
+        for (size_t i = 0; i < stream.size(); i += HW_READ_CHUNK_SIZE)
+        {
+            size_t n = stream.size() - i < HW_READ_CHUNK_SIZE ? stream.size() - i : HW_READ_CHUNK_SIZE;
+            monitor.feed(stream.data() + i, n);
+        }
+        break;
+    case ENTRY_PARSE:
+        monitor.parseFrames(stream.data(), stream.size());
+        break;
+    }
+}
+
+// The first MaxSensors sensors of the stream, nothing beyond them
+template <typename Monitor>
+static void checkStored(const Monitor &monitor, uint8_t capacity, uint32_t frames)
+{
+    CHECK(monitor.packetsOK == frames);
+    CHECK(monitor.packetsError == 0);
+    CHECK(monitor.sensorCount == capacity);
+
+    for (uint8_t i = 0; i < capacity; i++)
+    {
+        CHECK(monitor.isValid(testId(i)));
+        CHECK(monitor.get(testId(i)) == testValue(i));
+    }
+    CHECK(!monitor.isValid(testId(capacity)));
+}
+
+template <uint8_t MaxSensors>
+static void testKeyframes()
+{
+    const uint8_t versions[] = {HW_PROTO_VERSION_V2, HW_PROTO_VERSION_V3};
+    for (uint8_t v = 0; v < sizeof(versions); v++)
+    {
+        Bytes stream;
+        appendKeyframe(stream, versions[v]);
+
+        for (int e = ENTRY_BYTES; e <= ENTRY_PARSE; e++)
+        {
+            printf("keyframe v%u, %u of %u sensors, %s\n", versions[v], MaxSensors, TEST_SENSORS, entryNames[e]);
+            HWMonitorT<MaxSensors> monitor;
+            monitor.begin();
+            run(monitor, stream, (Entry)e);
+            checkStored(monitor, MaxSensors, 1);
+        }
+    }
+}
+
+template <uint8_t MaxSensors>
+static void testSchema()
+{
+    Bytes stream;
+    appendSchemaValues(stream);
+
+    for (int e = ENTRY_BYTES; e <= ENTRY_PARSE; e++)
+    {
+        printf("schema + values, %u of %u sensors, %s\n", MaxSensors, TEST_SENSORS, entryNames[e]);
+        HWMonitorT<MaxSensors> monitor;
+        monitor.begin();
+        run(monitor, stream, (Entry)e);
+        checkStored(monitor, MaxSensors, 2);
+        CHECK(monitor.schemaMisses == 0);
+    }
+}
+
+template <uint8_t MaxSensors>
+static void testScaled()
+{
+    Bytes stream;
+    appendScaled(stream);
+
+    // Only the first MaxSensors scales fit the table; the rest are not stored
+    for (int e = ENTRY_BYTES; e <= ENTRY_PARSE; e++)
+    {
+        printf("scale + int16, %u of %u sensors, %s\n", MaxSensors, TEST_SENSORS, entryNames[e]);
+        HWMonitorT<MaxSensors> monitor;
+        monitor.begin();
+        run(monitor, stream, (Entry)e);
+        checkStored(monitor, MaxSensors, 2);
+    }
+}
+
+int main()
+{
+    hostClockFreeze(1000);
+
+    testKeyframes<8>();
+    testKeyframes<16>();
+    testSchema<8>();
+    testSchema<16>();
+    testScaled<16>();
+
+    if (failures)
+    {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,272 @@
+/**
+ * @file hw_bench.cpp
+ * @brief Parser microbenchmarks on the host, across sensor counts and versions
+ *
+ * For every protocol version and sensor count, builds a stream of frames
+ * in memory and reports:
+ *  - processByte  ns per byte, one call per byte
+ *  - feed         ns per byte, 64-byte chunks as update() reads them
+ *  - parse        ns per byte, parseFrames() over the whole stream
+ *  - callbacks    ns per byte, feed with onSensor() and onFrame() set
+ *  - get / find   ns per lookup of every ID in the last frame
+ *
+ * The clock is frozen while measuring, so millis() in the commit path costs
+ * what it costs on the MCU: next to nothing. Timing uses the host's
+ * steady_clock directly.
+ *
+ * Usage: hw_bench [sensor count ...]
+ */
+
+#include <Arduino.h>
+#include "HWMonitor.h"
+
+#include <chrono>
+#include <stdlib.h>
+#include <vector>
+
+#define BENCH_STREAM_BYTES  32768   // frames per stream: about this many bytes
+#define BENCH_TOTAL_BYTES   4000000 // bytes parsed per measurement
+#define BENCH_CHUNK         64
+
+typedef HWMonitorT<HW_MAX_SENSORS> BenchMonitor;
+typedef std::vector<uint8_t> Bytes;
+
+static const uint8_t defaultCounts[] = {1, 2, 5, 10, 25, 50, 100, 150, 200, 250};
+
+static const uint8_t versions[] = {HW_PROTO_VERSION_V1, HW_PROTO_VERSION_V2, HW_PROTO_VERSION_V3};
+
+/*===========================================================================*/
+/*  STREAM                                                                   */
+/*===========================================================================*/
+
+static HWSensorId benchId(uint8_t version, uint8_t index)
+{
+    // v1 IDs are one byte; 0x00 and 0xFF are reserved
+    return version == HW_PROTO_VERSION_V1 ? index + 1 : 0x0100 + index;
+}
+
+static void appendFrame(Bytes &out, uint8_t version, uint8_t sensors, uint8_t seq, float base)
+{
+    size_t start = out.size();
+
+    out.push_back(HW_PROTO_START);
+    out.push_back(version);
+    if (version == HW_PROTO_VERSION_V3)
+    {
+        out.push_back(HW_FRAME_KEYFRAME | HW_ENC_FLOAT32);
+        out.push_back(seq);
+    }
+    out.push_back(sensors);
+
+    for (uint8_t i = 0; i < sensors; i++)
+    {
+        HWSensorId id = benchId(version, i);
+        if (version != HW_PROTO_VERSION_V1)
+        {
+            out.push_back(id >> 8);
+        }
+        out.push_back(id & 0xFF);
+
+        float value = base + i * 0.1f;
+        uint8_t bytes[4];
+        memcpy(bytes, &value, 4);
+        out.insert(out.end(), bytes, bytes + 4);
+    }
+
+    uint16_t crc = hwCrc16(out.data() + start + 1, out.size() - start - 1);
+    out.push_back(crc & 0xFF);
+    out.push_back(crc >> 8);
+    out.push_back(HW_PROTO_END);
+}
+
+static Bytes buildStream(uint8_t version, uint8_t sensors, size_t &frameLen)
+{
+    Bytes one;
+    appendFrame(one, version, sensors, 0, 0);
+    frameLen = one.size();
+
+    size_t frames = BENCH_STREAM_BYTES / frameLen;
+    if (frames < 4)
+        frames = 4;
+
+    Bytes stream;
+    stream.reserve(frames * frameLen);
+    for (size_t f = 0; f < frames; f++)
+    {
+        appendFrame(stream, version, sensors, (uint8_t)f, (float)f);
+    }
+    return stream;
+}
+
+/*===========================================================================*/
+/*  MEASUREMENTS                                                             */
+/*===========================================================================*/
+
+static uint64_t nowNs()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static volatile uint32_t sinkCount;
+static volatile float sinkValue;
+
+static void onSensor(HWSensorId id, float value)
+{
+    sinkCount = sinkCount + id;
+    sinkValue = value;
+}
+
+static void onFrame(const BenchMonitor::FrameView &frame)
+{
+    sinkCount = sinkCount + frame.count;
+}
+
+struct Result
+{
+    double processByte;
+    double feed;
+    double parse;
+    double callbacks;
+    double get;
+    double find;
+    bool ok;
+};
+
+static size_t repetitions(size_t len)
+{
+    size_t reps = BENCH_TOTAL_BYTES / len;
+    return reps ? reps : 1;
+}
+
+static double timeFeed(BenchMonitor &monitor, const Bytes &stream, size_t reps)
+{
+    uint64_t t0 = nowNs();
+    for (size_t r = 0; r < reps; r++)
+    {
+        for (size_t off = 0; off < stream.size(); off += BENCH_CHUNK)
+        {
+            size_t n = stream.size() - off < BENCH_CHUNK ? stream.size() - off : BENCH_CHUNK;
+            monitor.feed(stream.data() + off, n);
+        }
+    }
+    return (double)(nowNs() - t0) / ((double)stream.size() * reps);
+}
+
+static Result measure(uint8_t version, uint8_t sensors, size_t &frameLen)
+{
+    static BenchMonitor monitor;
+    Bytes stream = buildStream(version, sensors, frameLen);
+    size_t frames = stream.size() / frameLen;
+    size_t reps = repetitions(stream.size());
+    Result res;
+
+    monitor.begin();
+    monitor.reset();
+    uint64_t t0 = nowNs();
+    for (size_t r = 0; r < reps; r++)
+    {
+        for (size_t i = 0; i < stream.size(); i++)
+        {
+            monitor.processByte(stream[i]);
+        }
+    }
+    res.processByte = (double)(nowNs() - t0) / ((double)stream.size() * reps);
+    res.ok = monitor.packetsOK == frames * reps && monitor.packetsError == 0;
+
+    monitor.reset();
+    res.feed = timeFeed(monitor, stream, reps);
+    res.ok = res.ok && monitor.packetsOK == frames * reps;
+
+    monitor.reset();
+    t0 = nowNs();
+    for (size_t r = 0; r < reps; r++)
+    {
+        monitor.parseFrames(stream.data(), stream.size());
+    }
+    res.parse = (double)(nowNs() - t0) / ((double)stream.size() * reps);
+    res.ok = res.ok && monitor.packetsOK == frames * reps;
+
+    monitor.reset();
+    monitor.onSensor(onSensor);
+    monitor.onFrame(onFrame);
+    res.callbacks = timeFeed(monitor, stream, reps);
+    monitor.onSensor(nullptr);
+    monitor.onFrame(nullptr);
+
+    // Lookups against the state the last frame left
+    size_t lookups = repetitions(sensors * 16) * sensors;
+    size_t rounds = lookups / sensors;
+    float sum = 0;
+    t0 = nowNs();
+    for (size_t r = 0; r < rounds; r++)
+    {
+        for (uint8_t i = 0; i < sensors; i++)
+        {
+            sum += monitor.get(benchId(version, i));
+        }
+    }
+    res.get = (double)(nowNs() - t0) / lookups;
+
+    uint32_t found = 0;
+    t0 = nowNs();
+    for (size_t r = 0; r < rounds; r++)
+    {
+        for (uint8_t i = 0; i < sensors; i++)
+        {
+            found += monitor.findSensor(benchId(version, i)) ? 1 : 0;
+        }
+    }
+    res.find = (double)(nowNs() - t0) / lookups;
+    res.ok = res.ok && found == rounds * sensors;
+
+    sinkValue = sum;
+    return res;
+}
+
+/*===========================================================================*/
+/*  MAIN                                                                     */
+/*===========================================================================*/
+
+int main(int argc, char **argv)
+{
+    std::vector<uint8_t> counts;
+    for (int i = 1; i < argc; i++)
+    {
+        int n = atoi(argv[i]);
+        if (n < 1 || n > HW_MAX_SENSORS)
+        {
+            fprintf(stderr, "sensor count must be 1-%d: %s\n", HW_MAX_SENSORS, argv[i]);
+            return 1;
+        }
+        counts.push_back((uint8_t)n);
+    }
+    if (counts.empty())
+    {
+        counts.assign(defaultCounts, defaultCounts + sizeof(defaultCounts));
+    }
+
+    hostClockFreeze();
+
+    Serial.printf("=== HWMonitor host benchmark: ns/byte, ns/lookup ===\n");
+    Serial.printf("%-3s %4s %6s %12s %8s %8s %10s %8s %8s\n",
+                  "ver", "n", "frame", "processByte", "feed", "parse", "callbacks", "get", "find");
+
+    bool allOk = true;
+    for (uint8_t version : versions)
+    {
+        for (uint8_t sensors : counts)
+        {
+            size_t frameLen;
+            Result r = measure(version, sensors, frameLen);
+            allOk = allOk && r.ok;
+
+            Serial.printf("v%-2u %4u %6u %12.2f %8.2f %8.2f %10.2f %8.2f %8.2f%s\n",
+                          version, sensors, (unsigned)frameLen, r.processByte, r.feed,
+                          r.parse, r.callbacks, r.get, r.find, r.ok ? "" : "  FRAMES LOST");
+        }
+    }
+
+    fflush(stdout);
+    return allOk ? 0 : 1;
+}
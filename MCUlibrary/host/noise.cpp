@@ -0,0 +1,83 @@
+/**
+ * @file noise.cpp
+ * @brief Line-noise injector
+ */
+
+#include "noise.h"
+
+#include <math.h>
+
+NoiseInjector::NoiseInjector(const NoiseConfig &config)
+    : _config(config), _state(config.seed ? config.seed : 1)
+{
+    // At least one of the 8 bits flips
+    _byteFlipRate = 1.0 - pow(1.0 - config.bitErrorRate, 8);
+}
+
+uint32_t NoiseInjector::_next()
+{
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return _state;
+}
+
+bool NoiseInjector::_chance(double p)
+{
+    // Rates of 0 must not consume random numbers, so adding one error
+    // kind leaves the positions of the others unchanged
+    return p > 0 && _next() * (1.0 / 4294967296.0) < p;
+}
+
+void NoiseInjector::apply(const uint8_t *in, size_t len, std::vector<uint8_t> &out,
+                          std::vector<size_t> &map, std::vector<NoiseEvent> &events)
+{
+    out.clear();
+    map.clear();
+    events.clear();
+    out.reserve(len + len / 64);
+    map.reserve(len + 1);
+
+    size_t dropping = 0;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        map.push_back(out.size());
+
+        if (_chance(_config.markerRate))
+        {
+            events.push_back({i, out.size(), NOISE_MARKER});
+            out.push_back(_next() & 1 ? 0xAA : 0x55);
+        }
+
+        if (dropping)
+        {
+            dropping--;
+            continue;
+        }
+
+        if (_chance(_config.dropRate))
+        {
+            uint8_t burst = _config.dropBurstMax ? _config.dropBurstMax : 1;
+            events.push_back({i, out.size(), NOISE_DROP});
+            dropping = _next() % burst; // this byte plus the rest of the burst
+            continue;
+        }
+
+        uint8_t byte = in[i];
+        if (_chance(_byteFlipRate))
+        {
+            events.push_back({i, out.size(), NOISE_FLIP});
+            byte ^= 1 << (_next() & 7);
+        }
+        out.push_back(byte);
+
+        if (_chance(_config.duplicateRate))
+        {
+            events.push_back({i, out.size(), NOISE_DUPLICATE});
+            out.push_back(byte);
+        }
+    }
+
+    map.push_back(out.size());
+}
@@ -0,0 +1,75 @@
+/**
+ * @file noise.h
+ * @brief Deterministic line-noise injector for host-side parser runs
+ *
+ * Models what long USB-UART cables do to a byte stream: flipped bits,
+ * dropped bursts, duplicated bytes and stray 0xAA/0x55 bytes. The same seed
+ * always gives the same corruption, so two parser or framing versions can
+ * be compared on identical input.
+ */
+
+#ifndef HOST_NOISE_H
+#define HOST_NOISE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * @brief Error rates, all per clean byte except bitErrorRate (per bit)
+ */
+struct NoiseConfig
+{
+    double bitErrorRate;  // each bit flips with this probability
+    double dropRate;      // a burst of dropped bytes starts here
+    uint8_t dropBurstMax; // burst length is uniform in 1..dropBurstMax
+    double duplicateRate; // the byte is sent twice
+    double markerRate;    // a 0xAA or 0x55 is inserted before the byte
+    uint32_t seed;
+};
+
+enum NoiseKind
+{
+    NOISE_FLIP,
+    NOISE_DROP,
+    NOISE_DUPLICATE,
+    NOISE_MARKER
+};
+
+/**
+ * @brief One injected error
+ */
+struct NoiseEvent
+{
+    size_t clean; // offset in the clean stream
+    size_t noisy; // offset in the corrupted stream
+    NoiseKind kind;
+};
+
+class NoiseInjector
+{
+public:
+    explicit NoiseInjector(const NoiseConfig &config);
+
+    /**
+     * @brief Corrupt a clean stream
+     * @param in Clean bytes
+     * @param len Number of clean bytes
+     * @param out Receives the corrupted stream
+     * @param map Receives len + 1 entries, clean offset -> corrupted offset
+     * @param events Receives the injected errors in stream order
+     */
+    void apply(const uint8_t *in, size_t len, std::vector<uint8_t> &out,
+               std::vector<size_t> &map, std::vector<NoiseEvent> &events);
+
+private:
+    // xorshift32, never seeded with 0
+    uint32_t _next();
+    bool _chance(double p);
+
+    NoiseConfig _config;
+    double _byteFlipRate;
+    uint32_t _state;
+};
+
+#endif // HOST_NOISE_H
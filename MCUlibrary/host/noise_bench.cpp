@@ -0,0 +1,367 @@
+/**
+ * @file noise_bench.cpp
+ * @brief Frame recovery under line noise, per framing and noise profile
+ *
+ * Builds a stream of v2 keyframes (RAW, COBS or TEXT framing), corrupts it
+ * with NoiseInjector and feeds it to the real parser in 64-byte chunks.
+ * Frame k carries the values k, k + 1, ... so every committed frame can be
+ * traced back to the frame that was sent. Reports:
+ *  - hit        frames with at least one injected error
+ *  - ok         sent frames committed with the exact values that were sent
+ *  - lost       sent frames that were never committed
+ *  - clean      lost frames that had no error of their own
+ *  - false      committed frames that match no sent frame
+ *  - resync     bytes from an error to the start of the next committed
+ *               frame, mean and max; errors inside one outage count once
+ *  - lib        resync.events and resync.maxBytes as the parser sees them
+ *
+ * Results depend only on the seed, so the numbers are comparable across
+ * parser and framing changes.
+ *
+ * Usage: noise_bench [--seed N] [--frames N] [--sensors N]
+ */
+
+#include <Arduino.h>
+#include "HWMonitor.h"
+#include "noise.h"
+
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#define NOISE_CHUNK 64
+#define NOISE_MAX_SENSORS 64
+
+typedef HWMonitorT<NOISE_MAX_SENSORS> CrcMonitor;
+typedef HWMonitorT<NOISE_MAX_SENSORS, HWSensorId, HW_FEATURES_DEFAULT & ~HW_FEATURE_CRC> PlainMonitor;
+typedef std::vector<uint8_t> Bytes;
+
+struct Profile
+{
+    const char *name;
+    NoiseConfig noise;
+};
+
+// Seeds are filled in from --seed
+static Profile profiles[] = {
+    {"clean",     {0,    0,    0,  0,    0,    0}},
+    {"ber 1e-5",  {1e-5, 0,    0,  0,    0,    0}},
+    {"ber 1e-4",  {1e-4, 0,    0,  0,    0,    0}},
+    {"ber 1e-3",  {1e-3, 0,    0,  0,    0,    0}},
+    {"drop 1-16", {0,    1e-4, 16, 0,    0,    0}},
+    {"duplicate", {0,    0,    0,  1e-4, 0,    0}},
+    {"AA/55",     {0,    0,    0,  0,    1e-4, 0}},
+    {"mixed",     {1e-5, 3e-5, 16, 3e-5, 3e-5, 0}},
+};
+
+enum Framing
+{
+    FRAMING_RAW,
+    FRAMING_RAW_NOCRC,
+    FRAMING_COBS,
+    FRAMING_TEXT
+};
+
+static const char *const framingNames[] = {"raw", "raw nocrc", "cobs", "text"};
+
+/*===========================================================================*/
+/*  STREAM                                                                   */
+/*===========================================================================*/
+
+static HWSensorId noiseId(uint8_t index)
+{
+    return 0x0100 + index;
+}
+
+static void appendRaw(Bytes &out, uint8_t sensors, uint32_t frame)
+{
+    size_t start = out.size();
+
+    out.push_back(HW_PROTO_START);
+    out.push_back(HW_PROTO_VERSION_V2);
+    out.push_back(sensors);
+
+    for (uint8_t i = 0; i < sensors; i++)
+    {
+        out.push_back(noiseId(i) >> 8);
+        out.push_back(noiseId(i) & 0xFF);
+
+        float value = (float)(frame + i);
+        uint8_t bytes[4];
+        memcpy(bytes, &value, 4);
+        out.insert(out.end(), bytes, bytes + 4);
+    }
+
+    uint16_t crc = hwCrc16(out.data() + start + 1, out.size() - start - 1);
+    out.push_back(crc & 0xFF);
+    out.push_back(crc >> 8);
+    out.push_back(HW_PROTO_END);
+}
+
+static void appendCobs(Bytes &out, uint8_t sensors, uint32_t frame)
+{
+    Bytes raw;
+    appendRaw(raw, sensors, frame);
+
+    size_t start = out.size();
+    out.resize(start + raw.size() + raw.size() / 254 + 2);
+    out.resize(start + hwCobsEncode(raw.data(), raw.size(), out.data() + start));
+    out.push_back(HW_COBS_DELIMITER);
+}
+
+static void appendText(Bytes &out, uint8_t sensors, uint32_t frame)
+{
+    char line[32];
+    size_t start = out.size();
+
+    out.insert(out.end(), "$S\r\n", "$S\r\n" + 4);
+    for (uint8_t i = 0; i < sensors; i++)
+    {
+        int n = snprintf(line, sizeof(line), "%04X:%lu.0\r\n", noiseId(i), (unsigned long)(frame + i));
+        out.insert(out.end(), line, line + n);
+    }
+
+    uint8_t checksum = 0;
+    for (size_t i = start; i < out.size(); i++)
+    {
+        checksum ^= out[i];
+    }
+    int n = snprintf(line, sizeof(line), "$E:%02X\r\n", checksum);
+    out.insert(out.end(), line, line + n);
+}
+
+static Bytes buildStream(Framing framing, uint8_t sensors, uint32_t frames, std::vector<size_t> &starts)
+{
+    Bytes stream;
+    starts.clear();
+
+    for (uint32_t f = 0; f < frames; f++)
+    {
+        starts.push_back(stream.size());
+        if (framing == FRAMING_COBS)
+            appendCobs(stream, sensors, f);
+        else if (framing == FRAMING_TEXT)
+            appendText(stream, sensors, f);
+        else
+            appendRaw(stream, sensors, f);
+    }
+    starts.push_back(stream.size());
+    return stream;
+}
+
+/*===========================================================================*/
+/*  RUN                                                                      */
+/*===========================================================================*/
+
+struct Result
+{
+    uint32_t errors;
+    uint32_t hit;
+    uint32_t ok;
+    uint32_t lost;
+    uint32_t lostClean;
+    uint32_t falseAccepts;
+    uint32_t outages;
+    double meanResync;
+    size_t maxResync;
+    uint32_t libEvents;
+    uint32_t libMaxBytes;
+};
+
+// Filled by onFrame() while a stream is fed
+static struct
+{
+    uint8_t sensors;
+    uint32_t frames;
+    std::vector<uint8_t> committed;
+    uint32_t falseAccepts;
+} tally;
+
+static void onFrame(const HWFrameViewT<HWSensorId> &frame)
+{
+    uint32_t k = frame.count ? (uint32_t)frame.values[0] : 0;
+    bool genuine = frame.count == tally.sensors && k < tally.frames;
+
+    for (uint8_t i = 0; genuine && i < frame.count; i++)
+    {
+        genuine = frame.ids[i] == noiseId(i) && frame.values[i] == (float)(k + i);
+    }
+
+    if (genuine)
+        tally.committed[k] = 1;
+    else
+        tally.falseAccepts++;
+}
+
+template <typename Monitor>
+static void feedStream(Monitor &monitor, HWFraming framing, const Bytes &noisy, Result &res)
+{
+    monitor.begin();
+    monitor.setFraming(framing);
+    monitor.reset();
+    monitor.onFrame(onFrame);
+
+    for (size_t off = 0; off < noisy.size(); off += NOISE_CHUNK)
+    {
+        size_t n = noisy.size() - off < NOISE_CHUNK ? noisy.size() - off : NOISE_CHUNK;
+        monitor.feed(noisy.data() + off, n);
+    }
+
+    monitor.onFrame(nullptr);
+    res.libEvents = monitor.resync.events;
+    res.libMaxBytes = monitor.resync.maxBytes;
+}
+
+static Result run(Framing framing, const NoiseConfig &noise, uint8_t sensors, uint32_t frames)
+{
+    static CrcMonitor crcMonitor;
+    static PlainMonitor plainMonitor;
+
+    std::vector<size_t> starts;
+    Bytes clean = buildStream(framing, sensors, frames, starts);
+
+    Bytes noisy;
+    std::vector<size_t> map;
+    std::vector<NoiseEvent> events;
+    NoiseInjector injector(noise);
+    injector.apply(clean.data(), clean.size(), noisy, map, events);
+
+    Result res = {};
+    res.errors = events.size();
+
+    tally.sensors = sensors;
+    tally.frames = frames;
+    tally.committed.assign(frames, 0);
+    tally.falseAccepts = 0;
+
+    if (framing == FRAMING_RAW_NOCRC)
+        feedStream(plainMonitor, HW_FRAMING_RAW, noisy, res);
+    else if (framing == FRAMING_COBS)
+        feedStream(crcMonitor, HW_FRAMING_COBS, noisy, res);
+    else if (framing == FRAMING_TEXT)
+        feedStream(crcMonitor, HW_FRAMING_TEXT, noisy, res);
+    else
+        feedStream(crcMonitor, HW_FRAMING_RAW, noisy, res);
+
+    res.falseAccepts = tally.falseAccepts;
+
+    // Frames with an error of their own
+    std::vector<uint8_t> hit(frames, 0);
+    for (const NoiseEvent &e : events)
+    {
+        size_t f = std::upper_bound(starts.begin(), starts.end(), e.clean) - starts.begin() - 1;
+        hit[f] = 1;
+    }
+
+    // Where each committed frame starts in the corrupted stream
+    std::vector<size_t> committedAt;
+    for (uint32_t f = 0; f < frames; f++)
+    {
+        res.hit += hit[f];
+        if (tally.committed[f])
+        {
+            res.ok++;
+            committedAt.push_back(map[starts[f]]);
+        }
+        else
+        {
+            res.lost++;
+            res.lostClean += !hit[f];
+        }
+    }
+
+    // Errors before the end of the current outage belong to it
+    size_t recovered = 0;
+    double total = 0;
+    for (const NoiseEvent &e : events)
+    {
+        if (res.outages && e.noisy < recovered)
+            continue;
+
+        std::vector<size_t>::const_iterator next =
+            std::lower_bound(committedAt.begin(), committedAt.end(), e.noisy);
+        if (next == committedAt.end())
+            break; // never recovered before the stream ended
+
+        size_t distance = *next - e.noisy;
+        res.outages++;
+        total += distance;
+        res.maxResync = std::max(res.maxResync, distance);
+        recovered = *next + 1;
+    }
+    res.meanResync = res.outages ? total / res.outages : 0;
+
+    return res;
+}
+
+/*===========================================================================*/
+/*  MAIN                                                                     */
+/*===========================================================================*/
+
+static bool argValue(int argc, char **argv, int &i, const char *name, long &value)
+{
+    if (strcmp(argv[i], name) != 0 || i + 1 >= argc)
+        return false;
+    value = strtol(argv[++i], nullptr, 0);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    long seed = 1;
+    long frames = 5000;
+    long sensors = 20;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!argValue(argc, argv, i, "--seed", seed) &&
+            !argValue(argc, argv, i, "--frames", frames) &&
+            !argValue(argc, argv, i, "--sensors", sensors))
+        {
+            fprintf(stderr, "usage: %s [--seed N] [--frames N] [--sensors N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (sensors < 1 || sensors > NOISE_MAX_SENSORS || frames < 1 || frames > (1L << 24) - sensors)
+    {
+        fprintf(stderr, "sensors must be 1-%d, frames 1-%ld\n", NOISE_MAX_SENSORS, (1L << 24) - sensors);
+        return 1;
+    }
+
+    hostClockFreeze();
+
+    Serial.printf("=== HWMonitor line noise: %ld frames x %ld sensors, seed %ld ===\n",
+                  frames, sensors, seed);
+    Serial.printf("%-10s %-10s %7s %6s %6s %6s %6s %6s %9s %7s %7s %7s\n",
+                  "profile", "framing", "errors", "hit", "ok", "lost", "clean", "false",
+                  "resync", "max", "lib", "libmax");
+
+    bool cleanOk = true;
+    for (Profile &p : profiles)
+    {
+        p.noise.seed = (uint32_t)seed;
+
+        for (uint8_t f = FRAMING_RAW; f <= FRAMING_TEXT; f++)
+        {
+            Result r = run((Framing)f, p.noise, (uint8_t)sensors, (uint32_t)frames);
+
+            Serial.printf("%-10s %-10s %7lu %6lu %6lu %6lu %6lu %6lu %9.1f %7lu %7lu %7lu\n",
+                          p.name, framingNames[f], (unsigned long)r.errors, (unsigned long)r.hit,
+                          (unsigned long)r.ok, (unsigned long)r.lost, (unsigned long)r.lostClean,
+                          (unsigned long)r.falseAccepts, r.meanResync, (unsigned long)r.maxResync,
+                          (unsigned long)r.libEvents, (unsigned long)r.libMaxBytes);
+
+            if (!r.errors && (r.lost || r.falseAccepts))
+                cleanOk = false;
+        }
+    }
+
+    fflush(stdout);
+    if (!cleanOk)
+    {
+        fprintf(stderr, "FRAMES LOST without noise\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,20 @@
+/**
+ * @file sketch_main.cpp
+ * @brief Runs an Arduino sketch on the host: setup(), then loop() once
+ *
+ * The benchmarks in src/ do all their work in one loop() pass. delay()
+ * does not block on the host, so the run takes only the measured time.
+ */
+
+#include "Arduino.h"
+
+void setup();
+void loop();
+
+int main()
+{
+    setup();
+    loop();
+    fflush(stdout);
+    return 0;
+}
@@ -1,34 +1,43 @@
 /**
  * @file hw_monitor.h
  * @brief Hardware Monitor Parser Library for ESP-IDF
- * @version 1.0
- * 
+ * @version 2.0
+ *
+ * C interface to the HWMonitor parser (lib/HWMonitor). Each port gets its
+ * own context; all parsing, CRC, resync and framing code is the C++ one.
+ *
  * Usage:
- *   1. Call hw_monitor_init() once at startup
- *   2. Feed UART data to hw_monitor_process_byte() or hw_monitor_parse()
- *   3. Read values with hw_monitor_get_xxx() functions
+ *   1. hw_monitor_t* mon = hw_monitor_init(0);   (once per port)
+ *   2. Feed UART data to hw_monitor_process_byte() or hw_monitor_parse(),
+ *      or write it to a hw_ring_t and call hw_monitor_drain()
+ *   3. Read values with hw_monitor_get() or the hw_get_xxx(mon) getters
  */
 
-#ifndef HW_MONITOR_H
-#define HW_MONITOR_H
+#ifndef HW_MONITOR_C_H
+#define HW_MONITOR_C_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "hw_ring.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#include <stdint. h>
-#include <stdbool.h>
-#include <stddef.h>
-
 /*===========================================================================*/
-/*  PROTOCOL CONSTANTS                                                       */
+/*  CONFIGURATION                                                            */
 /*===========================================================================*/
 
-#define HW_PROTO_START      0xAA
-#define HW_PROTO_END        0x55
-#define HW_PROTO_VERSION    0x01
-#define HW_MAX_SENSORS      64
-#define HW_RX_BUFFER_SIZE   512
+/* Contexts hw_monitor_init() can hand out, one per port */
+#ifndef HW_MONITOR_PORTS
+#define HW_MONITOR_PORTS        2
+#endif
+
+/* Capacity of each context, at most 254 */
+#ifndef HW_MONITOR_MAX_SENSORS
+#define HW_MONITOR_MAX_SENSORS  64
+#endif
 
 /*===========================================================================*/
 /*  PREDEFINED SENSOR IDs                                                    */
@@ -72,64 +81,84 @@ extern "C" {
 #define SENSOR_NET_UP           0x40
 #define SENSOR_NET_DOWN         0x41
 
+/* Roles are the SENSOR_* IDs below this */
+#define HW_MONITOR_ROLE_COUNT   0x70
+
 /*===========================================================================*/
 /*  DATA TYPES                                                               */
 /*===========================================================================*/
 
+/* 8-bit IDs (v1 frames) and 16-bit IDs (v2/v3 frames) */
+typedef uint16_t hw_sensor_id_t;
+
 /**
  * @brief Single sensor data
  */
 typedef struct {
-    uint8_t id;           /**< Sensor ID */
-    float   value;        /**< Current value */
-    bool    valid;        /**< Data validity */
-    int64_t timestamp_ms; /**< Last update timestamp */
+    hw_sensor_id_t id;           /**< Sensor ID */
+    float          value;        /**< Current value */
+    bool           valid;        /**< Data validity */
+    uint32_t       timestamp_ms; /**< Last update timestamp */
 } hw_sensor_data_t;
 
 /**
- * @brief Parser state machine
+ * @brief Frame format, must match the host's "Framing" setting
  */
 typedef enum {
-    HW_STATE_IDLE,
-    HW_STATE_VERSION,
-    HW_STATE_COUNT,
-    HW_STATE_DATA,
-    HW_STATE_CRC_LOW,
-    HW_STATE_CRC_HIGH,
-    HW_STATE_END
-} hw_parser_state_t;
+    HW_MONITOR_FRAMING_RAW,   /**< START/END bytes (default) */
+    HW_MONITOR_FRAMING_COBS,  /**< COBS-stuffed, 0x00 delimited */
+    HW_MONITOR_FRAMING_TEXT   /**< $S / ID:VALUE / $E:XX lines */
+} hw_monitor_framing_t;
 
 /**
- * @brief Monitor context
+ * @brief Counters of one context
  */
 typedef struct {
-    hw_sensor_data_t sensors[HW_MAX_SENSORS];
-    uint8_t          sensor_count;
-    uint8_t          rx_buffer[HW_RX_BUFFER_SIZE];
-    size_t           rx_pos;
-    hw_parser_state_t state;
-    uint8_t          expected_count;
-    uint8_t          current_sensor;
-    uint8_t          byte_in_sensor;
-    uint32_t         packets_ok;
-    uint32_t         packets_err;
-    int64_t          last_update_ms;
-} hw_monitor_t;
+    uint32_t packets_ok;
+    uint32_t packets_err;
+    uint32_t crc_errors;
+    uint32_t resync_events;
+    uint32_t last_update_ms;  /**< Time of the last valid packet, 0: none yet */
+    uint8_t  sensor_count;
+} hw_monitor_stats_t;
 
-/*===========================================================================*/
-/*  GLOBAL INSTANCE                                                          */
-/*===========================================================================*/
+/**
+ * @brief Consistent copy of all sensors from one packet
+ *
+ * Filled by hw_monitor_snapshot(), with the role bindings that were current
+ * for that packet. Safe to read from any task or core.
+ */
+typedef struct {
+    hw_sensor_id_t ids[HW_MONITOR_MAX_SENSORS];
+    float          values[HW_MONITOR_MAX_SENSORS];
+    uint8_t        valid[(HW_MONITOR_MAX_SENSORS + 7) / 8]; /**< Bit per index */
+    hw_sensor_id_t role_ids[HW_MONITOR_ROLE_COUNT]; /**< ID bound to each SENSOR_* role */
+    uint8_t        sensor_count;
+    uint32_t       last_update_ms;
+    uint32_t       sequence;  /**< Changes with every published packet or role rebinding */
+} hw_snapshot_t;
 
-extern hw_monitor_t hw_monitor;
+/**
+ * @brief Parser context, one per port
+ */
+typedef struct hw_monitor hw_monitor_t;
 
 /*===========================================================================*/
 /*  INITIALIZATION                                                           */
 /*===========================================================================*/
 
 /**
- * @brief Initialize hardware monitor
+ * @brief Initialize (or reset) the context of a port
+ * @param port 0 .. HW_MONITOR_PORTS - 1
+ * @return Context for all other calls, NULL if port is out of range
+ */
+hw_monitor_t* hw_monitor_init(uint8_t port);
+
+/**
+ * @brief Select the frame format
+ * @return false if the format is compiled out
  */
-void hw_monitor_init(void);
+bool hw_monitor_set_framing(hw_monitor_t* mon, hw_monitor_framing_t framing);
 
 /*===========================================================================*/
 /*  PARSING                                                                  */
@@ -137,18 +166,51 @@ void hw_monitor_init(void);
 
 /**
  * @brief Process single byte (call from UART ISR or task)
+ * @param mon Context
  * @param byte Received byte
  * @return true if complete packet was parsed
  */
-bool hw_monitor_process_byte(uint8_t byte);
+bool hw_monitor_process_byte(hw_monitor_t* mon, uint8_t byte);
+
+/**
+ * @brief Parse a chunk of the stream
+ *
+ * Packets may span calls, an unfinished one is completed by the next.
+ *
+ * @param mon Context
+ * @param data Buffer pointer
+ * @param len Buffer length
+ * @return true if at least one valid packet found and parsed
+ */
+bool hw_monitor_parse(hw_monitor_t* mon, const uint8_t* data, size_t len);
 
 /**
- * @brief Parse complete buffer
+ * @brief Parse every complete packet in a buffer, in place
+ *
+ * Bytes after *consumed start an incomplete packet. Keep them at the
+ * front of the buffer and append the next read after them.
+ *
+ * @param mon Context
  * @param data Buffer pointer
  * @param len Buffer length
- * @return true if valid packet found and parsed
+ * @param consumed Optional, receives number of bytes consumed
+ * @return Number of valid packets parsed
+ */
+size_t hw_monitor_parse_frames(hw_monitor_t* mon, const uint8_t* data, size_t len, size_t* consumed);
+
+/**
+ * @brief Parse bytes a receive callback wrote to a ring
+ *
+ * The UART ISR or RX task only calls hw_ring_write(); parsing happens
+ * here, on the consumer's schedule. An unfinished packet is completed
+ * by the next call.
+ *
+ * @param mon Context
+ * @param ring Ring with a single producer, drained only here
+ * @param max_bytes Most bytes to take from the ring in this call
+ * @return Number of valid packets parsed
  */
-bool hw_monitor_parse(const uint8_t* data, size_t len);
+size_t hw_monitor_drain(hw_monitor_t* mon, hw_ring_t* ring, size_t max_bytes);
 
 /*===========================================================================*/
 /*  DATA ACCESS                                                              */
@@ -156,63 +218,120 @@ bool hw_monitor_parse(const uint8_t* data, size_t len);
 
 /**
  * @brief Get sensor value by ID
+ * @param mon Context
  * @param id Sensor ID
  * @return Value or -999.0f if not found/invalid
  */
-float hw_monitor_get(uint8_t id);
+float hw_monitor_get(const hw_monitor_t* mon, hw_sensor_id_t id);
 
 /**
  * @brief Check if sensor data is valid
+ * @param mon Context
  * @param id Sensor ID
  * @return true if valid
  */
-bool hw_monitor_valid(uint8_t id);
+bool hw_monitor_valid(const hw_monitor_t* mon, hw_sensor_id_t id);
 
 /**
- * @brief Get sensor pointer by ID
+ * @brief Copy a sensor by ID
+ * @param mon Context
  * @param id Sensor ID
- * @return Pointer to sensor data or NULL
+ * @param out Receives the sensor
+ * @return false if the ID is not in the last packet
+ */
+bool hw_monitor_find(const hw_monitor_t* mon, hw_sensor_id_t id, hw_sensor_data_t* out);
+
+/**
+ * @brief ID the host bound to a fixed SENSOR_* role
+ *
+ * The role itself until the host sends metadata.
  */
-hw_sensor_data_t* hw_monitor_find(uint8_t id);
+hw_sensor_id_t hw_monitor_role_id(const hw_monitor_t* mon, hw_sensor_id_t role);
 
 /**
  * @brief Invalidate all sensors (call on timeout)
  */
-void hw_monitor_invalidate_all(void);
+void hw_monitor_invalidate_all(hw_monitor_t* mon);
 
 /**
  * @brief Get time since last update
  * @return Milliseconds since last valid packet
  */
-int64_t hw_monitor_age_ms(void);
+uint32_t hw_monitor_age_ms(const hw_monitor_t* mon);
+
+/**
+ * @brief Read the counters
+ */
+void hw_monitor_get_stats(const hw_monitor_t* mon, hw_monitor_stats_t* stats);
+
+/**
+ * @brief Copy the last published packet without locking
+ *
+ * For readers on another task: every value in the copy comes from the
+ * same packet, unlike a series of hw_monitor_get() calls. The parser
+ * never waits; the copy is retried if a packet is published meanwhile.
+ *
+ * @param mon Context
+ * @param out Destination snapshot
+ * @return true if out holds a consistent packet
+ */
+bool hw_monitor_snapshot(const hw_monitor_t* mon, hw_snapshot_t* out);
+
+/**
+ * @brief Get sensor value from a snapshot
+ * @return Value or -999.0f if not found/invalid
+ */
+static inline float hw_snapshot_get(const hw_snapshot_t* snap, hw_sensor_id_t id)
+{
+    for (uint8_t i = 0; i < snap->sensor_count; i++) {
+        if (snap->ids[i] == id && ((snap->valid[i >> 3] >> (i & 7)) & 1)) {
+            return snap->values[i];
+        }
+    }
+    return -999.0f;
+}
+
+/**
+ * @brief Get the value bound to a fixed SENSOR_* role from a snapshot
+ * @return Value or -999.0f if not found/invalid
+ */
+static inline float hw_snapshot_role(const hw_snapshot_t* snap, hw_sensor_id_t role)
+{
+    return role < HW_MONITOR_ROLE_COUNT ? hw_snapshot_get(snap, snap->role_ids[role]) : -999.0f;
+}
 
 /*===========================================================================*/
 /*  CONVENIENCE GETTERS                                                      */
 /*===========================================================================*/
 
+static inline float hw_get_role(const hw_monitor_t* mon, hw_sensor_id_t role)
+{
+    return hw_monitor_get(mon, hw_monitor_role_id(mon, role));
+}
+
 /* CPU */
-static inline float hw_get_cpu_temp(void)       { return hw_monitor_get(SENSOR_CPU_TEMP_PKG); }
-static inline float hw_get_cpu_load(void)       { return hw_monitor_get(SENSOR_CPU_LOAD_TOTAL); }
-static inline float hw_get_cpu_clock(void)      { return hw_monitor_get(SENSOR_CPU_CLOCK); }
-static inline float hw_get_cpu_power(void)      { return hw_monitor_get(SENSOR_CPU_POWER_PKG); }
+static inline float hw_get_cpu_temp(const hw_monitor_t* mon)    { return hw_get_role(mon, SENSOR_CPU_TEMP_PKG); }
+static inline float hw_get_cpu_load(const hw_monitor_t* mon)    { return hw_get_role(mon, SENSOR_CPU_LOAD_TOTAL); }
+static inline float hw_get_cpu_clock(const hw_monitor_t* mon)   { return hw_get_role(mon, SENSOR_CPU_CLOCK); }
+static inline float hw_get_cpu_power(const hw_monitor_t* mon)   { return hw_get_role(mon, SENSOR_CPU_POWER_PKG); }
 
 /* GPU */
-static inline float hw_get_gpu_temp(void)       { return hw_monitor_get(SENSOR_GPU_TEMP_CORE); }
-static inline float hw_get_gpu_load(void)       { return hw_monitor_get(SENSOR_GPU_LOAD_CORE); }
-static inline float hw_get_gpu_clock(void)      { return hw_monitor_get(SENSOR_GPU_CLOCK_CORE); }
-static inline float hw_get_gpu_power(void)      { return hw_monitor_get(SENSOR_GPU_POWER); }
-static inline float hw_get_gpu_fan(void)        { return hw_monitor_get(SENSOR_GPU_FAN); }
-static inline float hw_get_gpu_hotspot(void)    { return hw_monitor_get(SENSOR_GPU_TEMP_HOTSPOT); }
+static inline float hw_get_gpu_temp(const hw_monitor_t* mon)    { return hw_get_role(mon, SENSOR_GPU_TEMP_CORE); }
+static inline float hw_get_gpu_load(const hw_monitor_t* mon)    { return hw_get_role(mon, SENSOR_GPU_LOAD_CORE); }
+static inline float hw_get_gpu_clock(const hw_monitor_t* mon)   { return hw_get_role(mon, SENSOR_GPU_CLOCK_CORE); }
+static inline float hw_get_gpu_power(const hw_monitor_t* mon)   { return hw_get_role(mon, SENSOR_GPU_POWER); }
+static inline float hw_get_gpu_fan(const hw_monitor_t* mon)     { return hw_get_role(mon, SENSOR_GPU_FAN); }
+static inline float hw_get_gpu_hotspot(const hw_monitor_t* mon) { return hw_get_role(mon, SENSOR_GPU_TEMP_HOTSPOT); }
 
 /* RAM */
-static inline float hw_get_ram_used(void)       { return hw_monitor_get(SENSOR_RAM_USED); }
-static inline float hw_get_ram_load(void)       { return hw_monitor_get(SENSOR_RAM_LOAD); }
+static inline float hw_get_ram_used(const hw_monitor_t* mon)    { return hw_get_role(mon, SENSOR_RAM_USED); }
+static inline float hw_get_ram_load(const hw_monitor_t* mon)    { return hw_get_role(mon, SENSOR_RAM_LOAD); }
 
 /* Disk */
-static inline float hw_get_disk_temp(void)      { return hw_monitor_get(SENSOR_DISK_TEMP); }
+static inline float hw_get_disk_temp(const hw_monitor_t* mon)   { return hw_get_role(mon, SENSOR_DISK_TEMP); }
 
 #ifdef __cplusplus
 }
 #endif
 
-#endif /* HW_MONITOR_H */
\ No newline at end of file
+#endif /* HW_MONITOR_C_H */
@@ -0,0 +1,410 @@
+/**
+ * @file HWDisplay.cpp
+ * @brief Widget, framebuffer and formatting implementation
+ */
+
+#include "HWDisplay.h"
+
+/*===========================================================================*/
+/*  FORMATTING                                                               */
+/*===========================================================================*/
+
+size_t hwFormatText(char *out, size_t size, const char *text)
+{
+    if (size == 0)
+        return 0;
+
+    size_t n = 0;
+    while (n + 1 < size && text[n])
+    {
+        out[n] = text[n];
+        n++;
+    }
+    out[n] = '\0';
+    return n;
+}
+
+// Reversed digits in tmp[0..len) to out, truncated to fit
+static size_t hwEmitReversed(char *out, size_t size, const char *tmp, size_t len)
+{
+    if (size == 0)
+        return 0;
+
+    size_t n = 0;
+    while (len > 0 && n + 1 < size)
+    {
+        out[n++] = tmp[--len];
+    }
+    out[n] = '\0';
+    return n;
+}
+
+size_t hwFormatUint(char *out, size_t size, uint32_t value)
+{
+    char tmp[10];
+    size_t len = 0;
+
+    do
+    {
+        tmp[len++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+
+    return hwEmitReversed(out, size, tmp, len);
+}
+
+size_t hwFormatFloat(char *out, size_t size, float value, uint8_t decimals)
+{
+    static const uint32_t scales[7] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+    if (decimals > 6)
+        decimals = 6;
+
+    bool negative = value < 0;
+    if (negative)
+        value = -value;
+
+    // Also catches NaN, which fails every comparison
+    if (!(value * scales[decimals] < 4294967040.0f))
+        return hwFormatText(out, size, "###");
+
+    uint32_t fixed = (uint32_t)(value * scales[decimals] + 0.5f);
+    negative = negative && fixed; // no "-0.0"
+
+    char tmp[19];
+    size_t len = 0;
+
+    for (uint8_t d = 0; d < decimals; d++)
+    {
+        tmp[len++] = '0' + fixed % 10;
+        fixed /= 10;
+    }
+    if (decimals)
+        tmp[len++] = '.';
+
+    do
+    {
+        tmp[len++] = '0' + fixed % 10;
+        fixed /= 10;
+    } while (fixed);
+
+    if (negative)
+        tmp[len++] = '-';
+
+    return hwEmitReversed(out, size, tmp, len);
+}
+
+/*===========================================================================*/
+/*  FRAMEBUFFER                                                              */
+/*===========================================================================*/
+
+void HWFramebuffer::_fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    if (!_pixels)
+        return;
+
+    int16_t x0 = x < 0 ? 0 : x;
+    int16_t y0 = y < 0 ? 0 : y;
+    int16_t x1 = x + w > _width ? _width : x + w;
+    int16_t y1 = y + h > _height ? _height : y + h;
+
+    for (int16_t row = y0; row < y1; row++)
+    {
+        uint16_t *p = _pixels + (int32_t)row * _width;
+        for (int16_t col = x0; col < x1; col++)
+        {
+            p[col] = color;
+        }
+    }
+}
+
+void HWFramebuffer::_drawText(int16_t x, int16_t y, const char *text, uint16_t fg, uint16_t bg, uint8_t size)
+{
+    int16_t cellW = HW_FONT_WIDTH * size;
+    int16_t cellH = HW_FONT_HEIGHT * size;
+
+    for (; *text; text++, x += cellW)
+    {
+        _fillRect(x, y, cellW, cellH, bg);
+        if (*text == ' ')
+            continue;
+
+        // 5x7 stand-in glyph, one column pattern per character code
+        for (uint8_t col = 0; col < HW_FONT_WIDTH - 1; col++)
+        {
+            uint8_t bits = (uint8_t)((uint8_t)*text * (col + 3) + col);
+            for (uint8_t row = 0; row < HW_FONT_HEIGHT - 1; row++)
+            {
+                if (bits & (1 << row))
+                    _fillRect(x + col * size, y + row * size, size, size, fg);
+            }
+        }
+    }
+}
+
+/*===========================================================================*/
+/*  LABEL & VALUE                                                            */
+/*===========================================================================*/
+
+HWLabel::HWLabel(int16_t x, int16_t y, uint8_t width, uint8_t size, uint16_t color, uint16_t bg)
+    : HWWidget(x, y), _width(width < HW_WIDGET_TEXT_SIZE ? width : HW_WIDGET_TEXT_SIZE - 1), _size(size), _color(color), _shownColor(color), _bg(bg)
+{
+    memset(_text, ' ', _width);
+    _text[_width] = '\0';
+    memcpy(_shown, _text, _width + 1);
+}
+
+void HWLabel::set(const char *text, uint16_t color)
+{
+    char padded[HW_WIDGET_TEXT_SIZE];
+    size_t len = hwFormatText(padded, _width + 1, text);
+    memset(padded + len, ' ', _width - len);
+    padded[_width] = '\0';
+
+    if (color == _color && memcmp(padded, _text, _width) == 0)
+        return;
+
+    memcpy(_text, padded, _width + 1);
+    _color = color;
+    _dirty = true;
+}
+
+void HWLabel::_draw(HWCanvas &canvas, bool full)
+{
+    // A new color touches every glyph
+    if (_color != _shownColor)
+        full = true;
+
+    int16_t cellW = HW_FONT_WIDTH * _size;
+    uint8_t i = 0;
+
+    while (i < _width)
+    {
+        if (!full && _text[i] == _shown[i])
+        {
+            i++;
+            continue;
+        }
+
+        uint8_t start = i;
+        while (i < _width && (full || _text[i] != _shown[i]))
+        {
+            i++;
+        }
+
+        char run[HW_WIDGET_TEXT_SIZE];
+        memcpy(run, _text + start, i - start);
+        run[i - start] = '\0';
+        canvas.drawText(_x + start * cellW, _y, run, _color, _bg, _size);
+    }
+
+    memcpy(_shown, _text, _width + 1);
+    _shownColor = _color;
+}
+
+HWValue::HWValue(int16_t x, int16_t y, uint8_t width, uint8_t decimals, const char *unit, uint8_t size, uint16_t bg)
+    : HWLabel(x, y, width, size, HW_COLOR_GREEN, bg), _unit(unit), _decimals(decimals < 6 ? decimals : 6), _warn(1e30f), _crit(1e30f)
+{
+    setColors(HW_COLOR_GREEN, HW_COLOR_YELLOW, HW_COLOR_RED);
+}
+
+void HWValue::set(float value)
+{
+    char text[HW_WIDGET_TEXT_SIZE];
+    size_t len;
+    uint16_t color;
+
+    if (value <= HW_VALUE_MISSING || value != value)
+    {
+        // "--.-" keeps the width of a real reading
+        len = hwFormatText(text, sizeof(text), "--");
+        if (_decimals)
+        {
+            text[len++] = '.';
+            for (uint8_t d = 0; d < _decimals; d++)
+            {
+                text[len++] = '-';
+            }
+        }
+        text[len] = '\0';
+        color = _colors[3];
+    }
+    else
+    {
+        len = hwFormatFloat(text, sizeof(text), value, _decimals);
+        color = value >= _crit ? _colors[2] : value >= _warn ? _colors[1] : _colors[0];
+    }
+
+    hwFormatText(text + len, sizeof(text) - len, _unit);
+    HWLabel::set(text, color);
+}
+
+/*===========================================================================*/
+/*  BAR                                                                      */
+/*===========================================================================*/
+
+HWBar::HWBar(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t track, uint16_t border)
+    : HWWidget(x, y), _w(w), _h(h), _fill(0), _shownFill(0), _color(track), _shownColor(track), _track(track), _border(border)
+{
+}
+
+void HWBar::set(float percent, uint16_t color)
+{
+    if (!(percent > 0))
+        percent = 0;
+    if (percent > 100)
+        percent = 100;
+
+    int16_t fill = (int16_t)(percent * (_w - 2) / 100.0f + 0.5f);
+
+    if (fill == _fill && (color == _color || fill == 0))
+        return;
+
+    _fill = fill;
+    _color = color;
+    _dirty = true;
+}
+
+void HWBar::_draw(HWCanvas &canvas, bool full)
+{
+    int16_t x = _x + 1;
+    int16_t y = _y + 1;
+    int16_t h = _h - 2;
+
+    if (full)
+    {
+        canvas.fillRect(_x, _y, _w, 1, _border);
+        canvas.fillRect(_x, _y + _h - 1, _w, 1, _border);
+        canvas.fillRect(_x, y, 1, h, _border);
+        canvas.fillRect(_x + _w - 1, y, 1, h, _border);
+        canvas.fillRect(x, y, _fill, h, _color);
+        canvas.fillRect(x + _fill, y, _w - 2 - _fill, h, _track);
+    }
+    else if (_color != _shownColor)
+    {
+        canvas.fillRect(x, y, _fill, h, _color);
+        if (_shownFill > _fill)
+            canvas.fillRect(x + _fill, y, _shownFill - _fill, h, _track);
+    }
+    else if (_fill > _shownFill)
+    {
+        canvas.fillRect(x + _shownFill, y, _fill - _shownFill, h, _color);
+    }
+    else
+    {
+        canvas.fillRect(x + _fill, y, _shownFill - _fill, h, _track);
+    }
+
+    _shownFill = _fill;
+    _shownColor = _color;
+}
+
+/*===========================================================================*/
+/*  GAUGE                                                                    */
+/*===========================================================================*/
+
+HWGauge::HWGauge(int16_t x, int16_t y, uint8_t segments, int16_t segmentW, int16_t segmentH, int16_t gap)
+    : HWWidget(x, y), _segments(segments), _lit(0), _shownLit(0), _segW(segmentW), _segH(segmentH), _gap(gap), _warn(70.0f), _crit(90.0f)
+{
+    _colors[0] = HW_COLOR_GREEN;
+    _colors[1] = HW_COLOR_YELLOW;
+    _colors[2] = HW_COLOR_RED;
+    _colors[3] = HW_COLOR_DARKGREY;
+}
+
+void HWGauge::set(float percent)
+{
+    uint8_t lit = 0;
+    if (percent > 0)
+    {
+        float segments = percent * _segments / 100.0f + 0.5f;
+        lit = segments >= _segments ? _segments : (uint8_t)segments;
+    }
+
+    if (lit == _lit)
+        return;
+
+    _lit = lit;
+    _dirty = true;
+}
+
+uint16_t HWGauge::_segmentColor(uint8_t segment) const
+{
+    if (segment >= _lit)
+        return _colors[3];
+
+    // Percentage where this segment ends
+    float end = (segment + 1) * 100.0f / _segments;
+    return end > _crit ? _colors[2] : end > _warn ? _colors[1] : _colors[0];
+}
+
+void HWGauge::_draw(HWCanvas &canvas, bool full)
+{
+    uint8_t from = full ? 0 : (_lit < _shownLit ? _lit : _shownLit);
+    uint8_t to = full ? _segments : (_lit > _shownLit ? _lit : _shownLit);
+
+    for (uint8_t s = from; s < to; s++)
+    {
+        canvas.fillRect(_x + s * (_segW + _gap), _y, _segW, _segH, _segmentColor(s));
+    }
+
+    _shownLit = _lit;
+}
+
+/*===========================================================================*/
+/*  SCREEN                                                                   */
+/*===========================================================================*/
+
+HWScreen::HWScreen(HWCanvas &canvas, uint16_t bg)
+    : _canvas(canvas), _count(0), _bg(bg), _cleared(false)
+{
+}
+
+bool HWScreen::add(HWWidget &widget)
+{
+    if (_count >= HW_SCREEN_MAX_WIDGETS)
+        return false;
+
+    _widgets[_count++] = &widget;
+    widget.invalidate();
+    return true;
+}
+
+void HWScreen::invalidate(bool clear)
+{
+    if (clear)
+        _cleared = false;
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        _widgets[i]->invalidate();
+    }
+}
+
+uint32_t HWScreen::render()
+{
+    uint32_t before = _canvas.stats.pixels;
+
+    if (!_cleared)
+    {
+        _canvas.fillRect(0, 0, _canvas.width(), _canvas.height(), _bg);
+        _cleared = true;
+    }
+
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        _widgets[i]->render(_canvas);
+    }
+
+    return _canvas.stats.pixels - before;
+}
+
+uint8_t HWScreen::dirtyCount() const
+{
+    uint8_t dirty = 0;
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        if (_widgets[i]->dirty())
+            dirty++;
+    }
+    return dirty;
+}
@@ -0,0 +1,428 @@
+/**
+ * @file HWDisplay.h
+ * @brief Dirty-tracking widgets for small TFT displays
+ *
+ * Widgets remember what they last drew and repaint only the regions whose
+ * pixels change: the differing characters of a label, the grown or shrunk
+ * end of a bar, the toggled segments of a gauge. Numbers are formatted into
+ * fixed buffers, nothing is allocated after construction.
+ *
+ * Drawing goes through HWCanvas. Sketches wrap their display driver in one,
+ * HWFramebuffer renders to memory so render cost and pixels pushed per frame
+ * can be measured on a host.
+ */
+
+#ifndef HW_DISPLAY_H
+#define HW_DISPLAY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/*===========================================================================*/
+/*  CONFIGURATION                                                            */
+/*===========================================================================*/
+
+// Characters a label can show, including the terminator
+#ifndef HW_WIDGET_TEXT_SIZE
+#define HW_WIDGET_TEXT_SIZE 32
+#endif
+
+#ifndef HW_SCREEN_MAX_WIDGETS
+#define HW_SCREEN_MAX_WIDGETS 24
+#endif
+
+// Character cell of the classic 6x8 GLCD font (TFT_eSPI font 1,
+// Adafruit_GFX default), multiplied by the text size
+#define HW_FONT_WIDTH 6
+#define HW_FONT_HEIGHT 8
+
+// Values at or below this are "no data", HWMonitor returns -999
+#define HW_VALUE_MISSING -900.0f
+
+/*===========================================================================*/
+/*  COLORS (RGB565, same values as TFT_eSPI)                                 */
+/*===========================================================================*/
+
+#define HW_RGB565(r, g, b) ((uint16_t)((((r) & 0xF8) << 8) | (((g) & 0xFC) << 3) | ((b) >> 3)))
+
+#define HW_COLOR_BLACK 0x0000
+#define HW_COLOR_WHITE 0xFFFF
+#define HW_COLOR_DARKGREY 0x7BEF
+#define HW_COLOR_CYAN 0x07FF
+#define HW_COLOR_GREEN 0x07E0
+#define HW_COLOR_YELLOW 0xFFE0
+#define HW_COLOR_RED 0xF800
+
+/*===========================================================================*/
+/*  FORMATTING                                                               */
+/*===========================================================================*/
+
+/**
+ * @brief Copy text into a fixed buffer
+ * @param out Destination, always terminated if size > 0
+ * @param size Size of out
+ * @param text Text to copy, truncated to fit
+ * @return Characters written, excluding the terminator
+ */
+size_t hwFormatText(char *out, size_t size, const char *text);
+
+/**
+ * @brief Format an unsigned integer without printf
+ * @return Characters written, excluding the terminator
+ */
+size_t hwFormatUint(char *out, size_t size, uint32_t value);
+
+/**
+ * @brief Format a float with fixed decimals, rounded half away from zero
+ *
+ * Works where printf has no float support (AVR). Values that do not fit
+ * 32 bits after scaling print as "###".
+ *
+ * @param decimals 0 to 6
+ * @return Characters written, excluding the terminator
+ */
+size_t hwFormatFloat(char *out, size_t size, float value, uint8_t decimals);
+
+/*===========================================================================*/
+/*  CANVAS                                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief What a canvas was asked to draw, since resetStats()
+ */
+struct HWDrawStats
+{
+    uint32_t pixels; // pixels pushed, text counts its full character cells
+    uint32_t rects;
+    uint32_t texts;
+};
+
+/**
+ * @brief Drawing target for widgets
+ *
+ * Implement _fillRect() and _drawText() for a display driver. The public
+ * calls count every pixel pushed, so all backends report the same stats.
+ */
+class HWCanvas
+{
+public:
+    HWDrawStats stats;
+
+    HWCanvas() { resetStats(); }
+    virtual ~HWCanvas() {}
+
+    virtual int16_t width() const = 0;
+    virtual int16_t height() const = 0;
+
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+        if (w <= 0 || h <= 0)
+            return;
+        stats.pixels += (uint32_t)w * h;
+        stats.rects++;
+        _fillRect(x, y, w, h, color);
+    }
+
+    /**
+     * @brief Draw text with an opaque background
+     *
+     * Fills HW_FONT_WIDTH x HW_FONT_HEIGHT cells times size per character,
+     * so spaces erase what was there.
+     */
+    void drawText(int16_t x, int16_t y, const char *text, uint16_t fg, uint16_t bg, uint8_t size)
+    {
+        size_t len = strlen(text);
+        if (!len)
+            return;
+        stats.pixels += (uint32_t)len * HW_FONT_WIDTH * HW_FONT_HEIGHT * size * size;
+        stats.texts++;
+        _drawText(x, y, text, fg, bg, size);
+    }
+
+    void resetStats() { memset(&stats, 0, sizeof(stats)); }
+
+protected:
+    virtual void _fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) = 0;
+    virtual void _drawText(int16_t x, int16_t y, const char *text, uint16_t fg, uint16_t bg, uint8_t size) = 0;
+};
+
+/**
+ * @brief Canvas over an RGB565 buffer in memory
+ *
+ * Characters are drawn as a pattern derived from their code instead of
+ * glyphs: the same cells are written as on a display, and different text
+ * still gives different pixels. With a null buffer only stats are kept.
+ */
+class HWFramebuffer : public HWCanvas
+{
+public:
+    /**
+     * @param pixels width * height entries, row-major, or nullptr
+     */
+    HWFramebuffer(uint16_t *pixels, int16_t width, int16_t height)
+        : _pixels(pixels), _width(width), _height(height)
+    {
+    }
+
+    int16_t width() const override { return _width; }
+    int16_t height() const override { return _height; }
+
+    const uint16_t *pixels() const { return _pixels; }
+
+    uint16_t pixel(int16_t x, int16_t y) const
+    {
+        if (!_pixels || x < 0 || y < 0 || x >= _width || y >= _height)
+            return 0;
+        return _pixels[(int32_t)y * _width + x];
+    }
+
+protected:
+    void _fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void _drawText(int16_t x, int16_t y, const char *text, uint16_t fg, uint16_t bg, uint8_t size) override;
+
+private:
+    uint16_t *_pixels;
+    int16_t _width;
+    int16_t _height;
+};
+
+/*===========================================================================*/
+/*  WIDGETS                                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief Base widget: a position and a dirty flag
+ *
+ * Setters mark the widget dirty only if its pixels would change.
+ * render() then repaints the changed part, or everything after
+ * invalidate().
+ */
+class HWWidget
+{
+public:
+    HWWidget(int16_t x, int16_t y) : _x(x), _y(y), _dirty(true), _drawn(false) {}
+    virtual ~HWWidget() {}
+
+    bool dirty() const { return _dirty; }
+
+    /**
+     * @brief Repaint the whole widget on the next render()
+     */
+    void invalidate()
+    {
+        _dirty = true;
+        _drawn = false;
+    }
+
+    void render(HWCanvas &canvas)
+    {
+        if (!_dirty)
+            return;
+        _draw(canvas, !_drawn);
+        _dirty = false;
+        _drawn = true;
+    }
+
+protected:
+    int16_t _x;
+    int16_t _y;
+    bool _dirty;
+    bool _drawn; // false until drawn on the current screen contents
+
+    /**
+     * @param full Draw everything, the area holds unknown pixels
+     */
+    virtual void _draw(HWCanvas &canvas, bool full) = 0;
+};
+
+/**
+ * @brief Text in a fixed-width field
+ *
+ * Shorter text is padded with spaces, so it erases what it replaces.
+ * Only runs of characters that differ from the shown text are redrawn.
+ */
+class HWLabel : public HWWidget
+{
+public:
+    /**
+     * @param width Field width in characters, below HW_WIDGET_TEXT_SIZE
+     */
+    HWLabel(int16_t x, int16_t y, uint8_t width, uint8_t size = 2, uint16_t color = HW_COLOR_WHITE, uint16_t bg = HW_COLOR_BLACK);
+
+    void set(const char *text) { set(text, _color); }
+    void set(const char *text, uint16_t color);
+
+    const char *text() const { return _text; }
+
+protected:
+    char _text[HW_WIDGET_TEXT_SIZE];  // padded to _width
+    char _shown[HW_WIDGET_TEXT_SIZE]; // what the canvas holds
+    uint8_t _width;
+    uint8_t _size;
+    uint16_t _color;
+    uint16_t _shownColor;
+    uint16_t _bg;
+
+    void _draw(HWCanvas &canvas, bool full) override;
+};
+
+/**
+ * @brief Number with unit, colored by thresholds
+ *
+ * Redraws when the formatted text or its color changes, not on every new
+ * value: 61.54 and 61.51 both show as "61.5C".
+ */
+class HWValue : public HWLabel
+{
+public:
+    /**
+     * @param unit Suffix, must outlive the widget (string literal)
+     */
+    HWValue(int16_t x, int16_t y, uint8_t width, uint8_t decimals, const char *unit, uint8_t size = 2, uint16_t bg = HW_COLOR_BLACK);
+
+    /**
+     * @brief Color above each threshold, defaults never switch
+     */
+    void setThresholds(float warn, float crit)
+    {
+        _warn = warn;
+        _crit = crit;
+    }
+
+    void setColors(uint16_t normal, uint16_t warn, uint16_t crit, uint16_t missing = HW_COLOR_DARKGREY)
+    {
+        _colors[0] = normal;
+        _colors[1] = warn;
+        _colors[2] = crit;
+        _colors[3] = missing;
+    }
+
+    /**
+     * @param value Shows dashes at or below HW_VALUE_MISSING or for NaN
+     */
+    void set(float value);
+
+private:
+    const char *_unit;
+    uint8_t _decimals;
+    float _warn;
+    float _crit;
+    uint16_t _colors[4];
+};
+
+/**
+ * @brief Horizontal bar, 0-100 %, with a 1 px border
+ *
+ * A changed value repaints only the strip between the old and new fill.
+ */
+class HWBar : public HWWidget
+{
+public:
+    HWBar(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t track = HW_COLOR_DARKGREY, uint16_t border = HW_COLOR_WHITE);
+
+    void set(float percent, uint16_t color);
+
+private:
+    int16_t _w;
+    int16_t _h;
+    int16_t _fill;
+    int16_t _shownFill;
+    uint16_t _color;
+    uint16_t _shownColor;
+    uint16_t _track;
+    uint16_t _border;
+
+    void _draw(HWCanvas &canvas, bool full) override;
+};
+
+/**
+ * @brief Segmented gauge, 0-100 %, segments colored by position
+ *
+ * Segments past the warn or crit percentage light in those colors.
+ * Only segments that toggle are repainted.
+ */
+class HWGauge : public HWWidget
+{
+public:
+    HWGauge(int16_t x, int16_t y, uint8_t segments, int16_t segmentW, int16_t segmentH, int16_t gap = 2);
+
+    void setThresholds(float warn, float crit)
+    {
+        _warn = warn;
+        _crit = crit;
+        invalidate();
+    }
+
+    void setColors(uint16_t normal, uint16_t warn, uint16_t crit, uint16_t off = HW_COLOR_DARKGREY)
+    {
+        _colors[0] = normal;
+        _colors[1] = warn;
+        _colors[2] = crit;
+        _colors[3] = off;
+        invalidate();
+    }
+
+    void set(float percent);
+
+private:
+    uint8_t _segments;
+    uint8_t _lit;
+    uint8_t _shownLit;
+    int16_t _segW;
+    int16_t _segH;
+    int16_t _gap;
+    float _warn;
+    float _crit;
+    uint16_t _colors[4];
+
+    uint16_t _segmentColor(uint8_t segment) const;
+    void _draw(HWCanvas &canvas, bool full) override;
+};
+
+/*===========================================================================*/
+/*  SCREEN                                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief Fixed list of widgets drawn on one canvas
+ */
+class HWScreen
+{
+public:
+    HWScreen(HWCanvas &canvas, uint16_t bg = HW_COLOR_BLACK);
+
+    /**
+     * @return false if HW_SCREEN_MAX_WIDGETS widgets are already added
+     */
+    bool add(HWWidget &widget);
+
+    /**
+     * @brief Repaint every widget on the next render()
+     * @param clear Fill the background first, else widgets paint over
+     *        what the display holds
+     */
+    void invalidate(bool clear = true);
+
+    /**
+     * @brief Draw the dirty widgets
+     * @return Pixels pushed to the canvas
+     */
+    uint32_t render();
+
+    /**
+     * @brief Number of widgets render() would draw
+     */
+    uint8_t dirtyCount() const;
+
+    HWCanvas &canvas() { return _canvas; }
+
+private:
+    HWCanvas &_canvas;
+    HWWidget *_widgets[HW_SCREEN_MAX_WIDGETS];
+    uint8_t _count;
+    uint16_t _bg;
+    bool _cleared;
+};
+
+#endif // HW_DISPLAY_H
@@ -1,399 +1,131 @@
 /**
  * @file HWMonitor. cpp
  * @brief Hardware Monitor Protocol Parser Implementation
+ *
+ * Only the non-template parts live here, HWMonitorT is defined in
+ * HWMonitorImpl.h.
  */
 
 #include "HWMonitor.h"
 
 /*===========================================================================*/
-/*  CONSTRUCTOR & INITIALIZATION                                             */
+/*  CRC CALCULATION                                                          */
 /*===========================================================================*/
 
-HWMonitor::HWMonitor()
-    : packetsOK(0), packetsError(0), sensorCount(0), lastUpdate(0), _state(HW_STATE_IDLE), _expectedCount(0), _currentSensor(0), _byteInSensor(0), _tempId(0), _crcLow(0), _crcHigh(0), _packetCallback(nullptr), _sensorCallback(nullptr)
-{
-}
-
-void HWMonitor::begin()
-{
-    reset();
-}
-
-void HWMonitor::reset()
-{
-    for (uint8_t i = 0; i < HW_MAX_SENSORS; i++)
-    {
-        _sensors[i].id = SENSOR_UNKNOWN;
-        _sensors[i].value = -999.0f;
-        _sensors[i].valid = false;
-        _sensors[i].timestamp = 0;
-    }
-
-    _state = HW_STATE_IDLE;
-    sensorCount = 0;
-    packetsOK = 0;
-    packetsError = 0;
-    lastUpdate = 0;
-}
+#if defined(__AVR__)
+const uint16_t hwCrc16Nibble[16] PROGMEM = {
+    0x0000, 0xCC01, 0xD801, 0x1400, 0xF001, 0x3C00, 0x2800, 0xE401,
+    0xA001, 0x6C00, 0x7800, 0xB401, 0x5000, 0x9C01, 0x8801, 0x4400,
+};
+#else
+const uint16_t hwCrc16Table[256] PROGMEM = {
+    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040,
+};
+#endif
 
 /*===========================================================================*/
-/*  STREAM UPDATE                                                            */
+/*  TEXT FRAMING                                                             */
 /*===========================================================================*/
 
-bool HWMonitor::update(Stream &stream)
-{
-    bool packetReceived = false;
-
-    while (stream.available())
-    {
-        if (processByte(stream.read()))
-        {
-            packetReceived = true;
-        }
-    }
-
-    return packetReceived;
-}
-
-/*===========================================================================*/
-/*  BYTE-BY-BYTE PARSER                                                      */
-/*===========================================================================*/
-
-bool HWMonitor::processByte(uint8_t byte)
-{
-    switch (_state)
-    {
-    case HW_STATE_IDLE:
-        if (byte == HW_PROTO_START)
-        {
-            _state = HW_STATE_VERSION;
-        }
-        break;
-
-    case HW_STATE_VERSION:
-        if (byte == HW_PROTO_VERSION)
-        {
-            _state = HW_STATE_COUNT;
-        }
-        else
-        {
-            _state = HW_STATE_IDLE;
-            packetsError++;
-        }
-        break;
-
-    case HW_STATE_COUNT:
-        _expectedCount = byte;
-        _currentSensor = 0;
-        _byteInSensor = 0;
-
-        if (byte > 0 && byte <= HW_MAX_SENSORS)
-        {
-            _state = HW_STATE_DATA;
-        }
-        else
-        {
-            _state = HW_STATE_IDLE;
-            packetsError++;
-        }
-        break;
-
-    case HW_STATE_DATA:
-        if (_byteInSensor == 0)
-        {
-            _tempId = byte;
-            _byteInSensor = 1;
-        }
-        else
-        {
-            _tempValue[_byteInSensor - 1] = byte;
-            _byteInSensor++;
-
-            if (_byteInSensor == 5)
-            {
-                _storeSensor();
-                _currentSensor++;
-                _byteInSensor = 0;
-
-                if (_currentSensor >= _expectedCount)
-                {
-                    _state = HW_STATE_CRC_LOW;
-                }
-            }
-        }
-        break;
-
-    case HW_STATE_CRC_LOW:
-        _crcLow = byte;
-        _state = HW_STATE_CRC_HIGH;
-        break;
-
-    case HW_STATE_CRC_HIGH:
-        _crcHigh = byte;
-        _state = HW_STATE_END;
-        break;
-
-    case HW_STATE_END:
-        _state = HW_STATE_IDLE;
-
-        if (byte == HW_PROTO_END)
-        {
-            return _finalizePacket();
-        }
-        else
-        {
-            packetsError++;
-        }
-        break;
-    }
-
-    return false;
-}
-
-void HWMonitor::_storeSensor()
-{
-    if (_currentSensor >= HW_MAX_SENSORS)
-        return;
-
-    // Convert bytes to float (little-endian)
-    union
-    {
-        float f;
-        uint8_t b[4];
-    } converter;
-
-    converter.b[0] = _tempValue[0];
-    converter.b[1] = _tempValue[1];
-    converter.b[2] = _tempValue[2];
-    converter.b[3] = _tempValue[3];
-
-    _sensors[_currentSensor].id = _tempId;
-    _sensors[_currentSensor].value = converter.f;
-    _sensors[_currentSensor].valid = true;
-    _sensors[_currentSensor].timestamp = millis();
-
-    // Call sensor callback if set
-    if (_sensorCallback)
-    {
-        _sensorCallback(_tempId, converter.f);
-    }
-}
-
-bool HWMonitor::_finalizePacket()
-{
-    sensorCount = _expectedCount;
-    lastUpdate = millis();
-    packetsOK++;
-
-    // Call packet callback if set
-    if (_packetCallback)
-    {
-        _packetCallback(sensorCount);
-    }
-
-    return true;
-}
+const float hwPow10[10] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f};
 
 /*===========================================================================*/
-/*  BUFFER PARSER                                                            */
+/*  COBS FRAMING                                                             */
 /*===========================================================================*/
 
-bool HWMonitor::parse(const uint8_t *data, size_t len)
+size_t hwCobsEncode(const uint8_t *src, size_t len, uint8_t *dst)
 {
-    if (!data || len < 6)
-        return false;
-
-    // Find start byte
-    size_t startIdx = 0;
-    while (startIdx < len && data[startIdx] != HW_PROTO_START)
-    {
-        startIdx++;
-    }
-
-    if (startIdx >= len)
-        return false;
-
-    const uint8_t *pkt = data + startIdx;
-    size_t remaining = len - startIdx;
-
-    // Check header
-    if (remaining < 3)
-        return false;
-    if (pkt[1] != HW_PROTO_VERSION)
-    {
-        packetsError++;
-        return false;
-    }
-
-    uint8_t count = pkt[2];
-    size_t expectedLen = 3 + (count * 5) + 3;
-
-    if (remaining < expectedLen)
-    {
-        packetsError++;
-        return false;
-    }
-
-    if (pkt[expectedLen - 1] != HW_PROTO_END)
-    {
-        packetsError++;
-        return false;
-    }
-
-    // Parse sensor data
-    size_t offset = 3;
-    for (uint8_t i = 0; i < count && i < HW_MAX_SENSORS; i++)
-    {
-        _sensors[i].id = pkt[offset];
-
-        union
-        {
-            float f;
-            uint8_t b[4];
-        } converter;
+    uint8_t *code = dst; // where the current block's length byte goes
+    uint8_t *out = dst + 1;
+    uint8_t run = 1;
 
-        converter.b[0] = pkt[offset + 1];
-        converter.b[1] = pkt[offset + 2];
-        converter.b[2] = pkt[offset + 3];
-        converter.b[3] = pkt[offset + 4];
-
-        _sensors[i].value = converter.f;
-        _sensors[i].valid = true;
-        _sensors[i].timestamp = millis();
-
-        if (_sensorCallback)
-        {
-            _sensorCallback(_sensors[i].id, converter.f);
-        }
-
-        offset += 5;
-    }
-
-    sensorCount = count;
-    lastUpdate = millis();
-    packetsOK++;
-
-    if (_packetCallback)
-    {
-        _packetCallback(sensorCount);
-    }
-
-    return true;
-}
-
-/*===========================================================================*/
-/*  DATA ACCESS                                                              */
-/*===========================================================================*/
-
-float HWMonitor::get(uint8_t id, float defaultValue) const
-{
-    for (uint8_t i = 0; i < sensorCount; i++)
+    for (size_t i = 0; i < len; i++)
     {
-        if (_sensors[i].id == id && _sensors[i].valid)
+        if (src[i] == 0)
         {
-            return _sensors[i].value;
+            *code = run;
+            code = out++;
+            run = 1;
+            continue;
         }
-    }
-    return defaultValue;
-}
 
-bool HWMonitor::isValid(uint8_t id) const
-{
-    for (uint8_t i = 0; i < sensorCount; i++)
-    {
-        if (_sensors[i].id == id)
+        *out++ = src[i];
+        if (++run == 0xFF)
         {
-            return _sensors[i].valid;
+            // Full block of 254 bytes, no implied zero after it
+            *code = run;
+            code = out++;
+            run = 1;
         }
     }
-    return false;
-}
 
-const HWSensor *HWMonitor::getSensorByIndex(uint8_t index) const
-{
-    if (index < sensorCount)
-    {
-        return &_sensors[index];
-    }
-    return nullptr;
+    *code = run;
+    return out - dst;
 }
 
-const HWSensor *HWMonitor::findSensor(uint8_t id) const
+size_t hwCobsDecode(const uint8_t *src, size_t len, uint8_t *dst)
 {
-    for (uint8_t i = 0; i < sensorCount; i++)
-    {
-        if (_sensors[i].id == id)
-        {
-            return &_sensors[i];
-        }
-    }
-    return nullptr;
-}
+    size_t in = 0;
+    size_t out = 0;
 
-void HWMonitor::invalidateAll()
-{
-    for (uint8_t i = 0; i < HW_MAX_SENSORS; i++)
+    while (in < len)
     {
-        _sensors[i].valid = false;
-    }
-}
+        uint8_t code = src[in++];
+        size_t run = code - 1;
 
-bool HWMonitor::isStale(uint32_t timeoutMs) const
-{
-    if (lastUpdate == 0)
-        return true;
-    return (millis() - lastUpdate) > timeoutMs;
-}
+        if (code == 0 || run > len - in)
+            return HW_COBS_ERROR;
 
-uint32_t HWMonitor::getAge() const
-{
-    if (lastUpdate == 0)
-        return UINT32_MAX;
-    return millis() - lastUpdate;
-}
-
-void HWMonitor::onPacket(HWPacketCallback callback)
-{
-    _packetCallback = callback;
-}
-
-void HWMonitor::onSensor(HWSensorCallback callback)
-{
-    _sensorCallback = callback;
-}
+        // Output never overtakes input, so in-place decoding is safe
+        memmove(dst + out, src + in, run);
+        in += run;
+        out += run;
 
-/*===========================================================================*/
-/*  CRC CALCULATION                                                          */
-/*===========================================================================*/
-
-uint16_t HWMonitor::_calculateCRC(const uint8_t *data, size_t len) const
-{
-    uint16_t crc = 0xFFFF;
-
-    for (size_t i = 0; i < len; i++)
-    {
-        crc ^= data[i];
-        for (uint8_t j = 0; j < 8; j++)
+        if (code != 0xFF && in < len)
         {
-            if (crc & 0x0001)
-            {
-                crc = (crc >> 1) ^ 0xA001;
-            }
-            else
-            {
-                crc = crc >> 1;
-            }
+            dst[out++] = 0;
         }
     }
 
-    return crc;
+    return out;
 }
 
 /*===========================================================================*/
 /*  UTILITY FUNCTIONS                                                        */
 /*===========================================================================*/
 
-const char *hwGetSensorName(uint8_t id)
+const char *hwGetSensorName(HWSensorId id)
 {
     switch (id)
     {
@@ -488,7 +220,7 @@ const char *hwGetSensorName(uint8_t id)
     }
 }
 
-const char *hwGetSensorUnit(uint8_t id)
+const char *hwGetSensorUnit(HWSensorId id)
 {
     switch (id)
     {
@@ -557,7 +289,7 @@ const char *hwGetSensorUnit(uint8_t id)
     }
 }
 
-const char *hwGetSensorCategory(uint8_t id)
+const char *hwGetSensorCategory(HWSensorId id)
 {
     if (id >= 0x01 && id <= 0x0F)
         return "CPU";
@@ -573,7 +305,7 @@ const char *hwGetSensorCategory(uint8_t id)
         return "Motherboard";
     if (id >= 0x60 && id <= 0x6F)
         return "Battery";
-    if (id >= 0x80 && id <= 0xFE)
+    if (id >= 0x80 && id <= 0xFFFD)
         return "Custom";
     return "Unknown";
 }
\ No newline at end of file
@@ -11,22 +11,43 @@
  *   1. Create instance: HWMonitor monitor;
  *   2. In setup(): monitor.begin();
  *   3. In loop(): monitor.update(Serial);  // or any Stream
- *   4. Read values: float temp = monitor.get(SENSOR_CPU_TEMP);
+ *   4. Read values: float temp = monitor.get(roleId(SENSOR_CPU_TEMP));
+ *
+ * Small targets can size the parser at compile time instead:
+ *   HWMonitorT<8, uint8_t, HW_FEATURE_CRC> monitor;  // 8 sensors, CRC only
+ *
+ * For a host sending COBS frames ("Framing": "Cobs"):
+ *   monitor.setFraming(HW_FRAMING_COBS);
+ *
+ * For a host in text mode ("ProtocolMode": "Text"):
+ *   monitor.setFraming(HW_FRAMING_TEXT);
  */
 
 #ifndef HW_MONITOR_H
 #define HW_MONITOR_H
 
+#if defined(ESP_PLATFORM) && !defined(ARDUINO)
+#include "hw_idf.h" // ESP-IDF without the Arduino core
+#else
 #include <Arduino.h>
+#endif
+#include <string.h>
+#include <math.h>
+#include "hw_ring.h"
 
 /*===========================================================================*/
 /*  CONFIGURATION                                                            */
 /*===========================================================================*/
 
+// Capacity of the default HWMonitor. At most 254, slot 0xFF marks an
+// empty index bucket. Use HWMonitorT<N> for a smaller instance.
 #ifndef HW_MAX_SENSORS
 #define HW_MAX_SENSORS 250
 #endif
 
+// Upper bound for the resync lookback window. Each instance only
+// allocates the largest frame it stores (5 + N * 6 + 3 bytes); COBS
+// frames must fit it, raw frames with more sensors stream through.
 #ifndef HW_RX_BUFFER_SIZE
 #define HW_RX_BUFFER_SIZE 2048
 #endif
@@ -35,13 +56,169 @@
 #define HW_TIMEOUT_MS 5000
 #endif
 
+// Reject frames whose CRC-16/MODBUS does not match
+#ifndef HW_VERIFY_CRC
+#define HW_VERIFY_CRC 1
+#endif
+
+// Stack chunk used by update() to drain the stream with readBytes()
+#ifndef HW_READ_CHUNK_SIZE
+#define HW_READ_CHUNK_SIZE 64
+#endif
+
+// Default for drain(): bytes parsed per call, bounds the time spent there
+#ifndef HW_RING_BATCH_SIZE
+#define HW_RING_BATCH_SIZE 256
+#endif
+
+// Default for HWMultiMonitorT::poll(): microseconds shared by all ports
+#ifndef HW_POLL_BUDGET_US
+#define HW_POLL_BUDGET_US 2000
+#endif
+
+// Frames the host may send ahead of the last ACK with enableFlowControl().
+// Keep window * frame size within the Stream's RX buffer.
+#ifndef HW_FLOW_WINDOW
+#define HW_FLOW_WINDOW 2
+#endif
+
+// Most IDs subscribe() keeps, and how often update() repeats the set.
+#ifndef HW_MAX_SUBSCRIBE
+#define HW_MAX_SUBSCRIBE 32
+#endif
+
+#ifndef HW_SUBSCRIBE_INTERVAL_MS
+#define HW_SUBSCRIBE_INTERVAL_MS 2000
+#endif
+
+// Bytes for sensor names and units from META frames, equal strings are
+// stored once
+#ifndef HW_META_ARENA_SIZE
+#define HW_META_ARENA_SIZE 2048
+#endif
+
+// Deadband rules setDeadband() and setCategoryDeadband() can hold
+#ifndef HW_MAX_DEADBANDS
+#define HW_MAX_DEADBANDS 8
+#endif
+
+/*===========================================================================*/
+/*  FEATURES                                                                 */
+/*===========================================================================*/
+
+// Optional parts of HWMonitorT, disabled ones cost no code or RAM
+#define HW_FEATURE_CRC 0x01        // Verify CRC-16/MODBUS
+#define HW_FEATURE_TIMESTAMPS 0x02 // Per-sensor update time, else frame time
+#define HW_FEATURE_CALLBACKS 0x04  // onPacket() / onSensor()
+#define HW_FEATURE_RESYNC 0x08     // Lookback buffer replayed after errors
+#define HW_FEATURE_SCALED 0x10     // Per-sensor scale table for int16 values
+#define HW_FEATURE_COBS 0x20       // setFraming(HW_FRAMING_COBS)
+#define HW_FEATURE_SCHEMA 0x40     // Cached ID order for value-only frames
+#define HW_FEATURE_META 0x80       // Names, units and roles from META frames
+#define HW_FEATURE_DEADBAND 0x100  // Last reported value per sensor, changed()
+#define HW_FEATURE_TEXT 0x200      // setFraming(HW_FRAMING_TEXT)
+#define HW_FEATURE_ALL 0x3FF
+
+// The scale table (10 bytes per sensor), the schema cache (one ID per
+// sensor), the metadata arena and the reported values (5 bytes per
+// sensor) are too much for a default on AVR
+#if defined(__AVR__)
+#define HW_FEATURES_PLATFORM (HW_FEATURE_ALL & ~HW_FEATURE_SCALED & ~HW_FEATURE_SCHEMA & ~HW_FEATURE_META & ~HW_FEATURE_DEADBAND)
+#else
+#define HW_FEATURES_PLATFORM HW_FEATURE_ALL
+#endif
+
+#ifndef HW_FEATURES_DEFAULT
+#define HW_FEATURES_DEFAULT (HW_FEATURES_PLATFORM & ~HW_FEATURE_TIMESTAMPS & ~(HW_VERIFY_CRC ? 0 : HW_FEATURE_CRC))
+#endif
+
 /*===========================================================================*/
 /*  PROTOCOL CONSTANTS                                                       */
 /*===========================================================================*/
 
 #define HW_PROTO_START 0xAA
 #define HW_PROTO_END 0x55
-#define HW_PROTO_VERSION 0x01
+#define HW_PROTO_VERSION_V1 0x01 // 8-bit IDs, 5-byte records
+#define HW_PROTO_VERSION_V2 0x02 // 16-bit big-endian IDs, 6-byte records
+#define HW_PROTO_VERSION_V3 0x03 // v2 records after a TYPE and SEQ byte
+#define HW_PROTO_VERSION HW_PROTO_VERSION_V2
+
+// v3 frame: [AA][03][TYPE][SEQ][COUNT][records][CRC lo][CRC hi][55]
+// SEQ increments by one per frame, so a gap means frames were lost.
+// Low nibble of TYPE is the frame kind, high nibble the value encoding.
+#define HW_FRAME_KEYFRAME 0x00 // Every sensor, replaces the layout
+#define HW_FRAME_DELTA 0x01    // Changed sensors only, applied by ID
+#define HW_FRAME_SCALE 0x02    // [ID_HI][ID_LO][SCALE f32][OFFSET f32] records
+#define HW_FRAME_SCHEMA 0x03   // [ID_HI][ID_LO] records, the order of VALUES frames
+#define HW_FRAME_VALUES 0x04   // Values only, in schema order, replaces the layout
+#define HW_FRAME_KIND_MASK 0x0F
+#define HW_MAX_RECORDS 254 // records per frame, at most; receivers keep what they can store
+#define HW_SCALE_RECORDS 32 // records per SCALE frame, at most
+
+// Reverse channel, MCU to host, v3 header without records:
+// [AA][03][TYPE][SEQ][CREDIT][CRC lo][CRC hi][55]
+// SEQ is the last frame received, CREDIT how many frames may follow it
+// before the next ACK (0xFF: no limit).
+#define HW_FRAME_ACK 0x05
+#define HW_FRAME_NACK 0x06 // ACK that also asks for a keyframe
+#define HW_STATUS_WANT_META 0x10 // TYPE flag: no META frames since reset
+#define HW_STATUS_SIZE 8
+#define HW_STATUS_MAX_SIZE (HW_STATUS_SIZE + 2) // COBS-encoded, with delimiter
+
+// Interest set, MCU to host, laid out like a SCHEMA frame with SEQ 0:
+// [AA][03][07][00][COUNT][ID_HI][ID_LO]...[CRC lo][CRC hi][55]
+// The host sends only these sensors. COUNT 0 clears the set.
+#define HW_FRAME_SUBSCRIBE 0x07
+
+// Metadata, host to MCU, fixed-size records with zero-padded strings:
+// [ID_HI][ID_LO][ROLE][UNIT x5][NAME x16]
+// ROLE is the fixed SENSOR_* ID this sensor stands for (0: none), so
+// getCpuTemp() keeps working with IDs assigned by the host. A set spans
+// several frames; HW_META_RESET in TYPE marks the first one.
+#define HW_FRAME_META 0x08
+#define HW_META_RESET 0x10
+#define HW_META_UNIT_SIZE 5
+#define HW_META_NAME_SIZE 16
+#define HW_META_RECORDS 8 // records per META frame, at most
+#define HW_ROLE_COUNT 0x70 // roles are SENSOR_* IDs below this
+
+// VALUES frames name their schema by hash, after SEQ:
+// [AA][03][TYPE][SEQ][HASH lo][HASH hi][COUNT][values][CRC lo][CRC hi][55]
+// The hash is CRC-16/MODBUS over the ID bytes of the SCHEMA frame records.
+
+#define HW_ENC_FLOAT32 0x00 // [ID_HI][ID_LO][FLOAT x4]
+#define HW_ENC_FLOAT16 0x10 // [ID_HI][ID_LO][HALF x2], IEEE 754 binary16
+#define HW_ENC_INT16 0x20   // [ID_HI][ID_LO][INT16 x2], value = raw * scale + offset
+#define HW_ENC_MASK 0xF0
+
+// CRC-16/MODBUS over VERSION..last data byte, sent low byte first
+#define HW_CRC_INIT 0xFFFF
+
+#define HW_HEADER_SIZE 3    // START, VERSION, COUNT
+#define HW_HEADER_SIZE_V3 5 // START, VERSION, TYPE, SEQ, COUNT
+#define HW_HEADER_SIZE_VALUES 7 // v3 header plus schema hash
+#define HW_RECORD_SIZE_V1 5
+#define HW_RECORD_SIZE_V2 6
+#define HW_RECORD_SIZE_16 4    // float16 or int16 value
+#define HW_RECORD_SIZE_ID 2    // SCHEMA record
+#define HW_RECORD_SIZE_SCALE 10
+#define HW_RECORD_SIZE_META (3 + HW_META_UNIT_SIZE + HW_META_NAME_SIZE)
+#define HW_MAX_RECORD_SIZE HW_RECORD_SIZE_META
+
+// Text framing, the host's text mode, readable in a terminal:
+// $S\r\n  XXXX:VALUE\r\n ...  $E:XX\r\n
+// ID is hex, VALUE decimal with '.' (',' from older hosts). XX is the
+// XOR of every byte from the '$' of $S through the newline before $E.
+// '$' never occurs inside a line, so it marks a frame boundary.
+#define HW_TEXT_MARK '$'
+#define HW_TEXT_START 'S'
+#define HW_TEXT_END 'E'
+#define HW_TEXT_MAX_LINE 32 // longer lines are a framing error
+
+// COBS framing: each frame above is byte-stuffed so it contains no 0x00,
+// then terminated by a single 0x00. Costs 1 byte per 254 plus the delimiter.
+#define HW_COBS_DELIMITER 0x00
+#define HW_COBS_ERROR ((size_t)-1)
 
 /*===========================================================================*/
 /*  SENSOR IDs                                                               */
@@ -97,24 +274,201 @@
 #define SENSOR_BATTERY_VOLTAGE 0x61
 #define SENSOR_BATTERY_RATE 0x62
 
-// Invalid/Unknown
-#define SENSOR_UNKNOWN 0xFF
+// Invalid/Unknown (0xFFFE and 0xFFFF are never assigned by the host)
+#define SENSOR_UNKNOWN 0xFFFF
+
+// Categories for setCategoryDeadband(), the high nibble of the IDs above
+#define HW_CATEGORY_CPU 0x0
+#define HW_CATEGORY_GPU 0x1
+#define HW_CATEGORY_RAM 0x2
+#define HW_CATEGORY_DISK 0x3
+#define HW_CATEGORY_NET 0x4
+#define HW_CATEGORY_MB 0x5
+#define HW_CATEGORY_BATTERY 0x6
+#define HW_CATEGORY_NONE 0xFF // custom IDs without a role
 
 /*===========================================================================*/
 /*  DATA STRUCTURES                                                          */
 /*===========================================================================*/
 
+/**
+ * @brief Sensor ID (8-bit IDs from v1 frames are widened)
+ */
+typedef uint16_t HWSensorId;
+
 /**
  * @brief Single sensor data
+ *
+ * Not how sensors are stored: the monitor keeps ids, values and validity
+ * bits in separate arrays and assembles this on lookup.
  */
-struct HWSensor
+template <typename IdType>
+struct HWSensorT
 {
-    uint8_t id;
+    IdType id;
     float value;
     bool valid;
     uint32_t timestamp;
 };
 
+typedef HWSensorT<HWSensorId> HWSensor;
+
+/**
+ * @brief Result of a sensor lookup
+ *
+ * Holds a copy of the sensor, so it stays valid after the next frame.
+ * Use like a pointer: if (view && view->valid) { ... view->value ... }
+ */
+template <typename Sensor>
+class HWSensorView
+{
+public:
+    HWSensorView() : _sensor(), _found(false) {}
+    explicit HWSensorView(const Sensor &sensor) : _sensor(sensor), _found(true) {}
+
+    explicit operator bool() const { return _found; }
+    const Sensor *operator->() const { return &_sensor; }
+    const Sensor &operator*() const { return _sensor; }
+
+private:
+    Sensor _sensor;
+    bool _found;
+};
+
+/**
+ * @brief Bytes needed for one validity bit per sensor
+ */
+constexpr uint8_t hwBitmaskSize(uint8_t bits)
+{
+    return (bits + 7) / 8;
+}
+
+/**
+ * @brief Test bit n of a validity bitmask
+ */
+inline bool hwBitTest(const uint8_t *mask, uint8_t n)
+{
+    return (mask[n >> 3] >> (n & 7)) & 1;
+}
+
+/**
+ * @brief Deadband rule for one ID, or for every sensor of a category
+ */
+struct HWDeadband
+{
+    HWSensorId id;    // SENSOR_UNKNOWN for a category rule
+    uint8_t category; // HW_CATEGORY_*
+    float absolute;
+    float relative;
+};
+
+/**
+ * @brief The sensor table right after a frame was validated
+ *
+ * Points into the parser's published bank, so it is only valid inside the
+ * callback (or until the next update()/feed() for the functor variants).
+ */
+template <typename IdType>
+struct HWFrameViewT
+{
+    const IdType *ids;
+    const float *values;
+    const uint8_t *changed; // bit per slot, see HWMonitorT::changedMask()
+    uint8_t count;
+
+    bool isChanged(uint8_t index) const
+    {
+        return index < count && hwBitTest(changed, index);
+    }
+
+    /**
+     * @brief Call fn(id, value) for each changed sensor, 8 slots per mask byte
+     */
+    template <typename Fn>
+    void forEachChanged(Fn &&fn) const
+    {
+        for (uint16_t base = 0; base < count; base += 8)
+        {
+            uint8_t bits = changed[base >> 3];
+            for (uint8_t i = (uint8_t)base; bits && i < count; i++, bits >>= 1)
+            {
+                if (bits & 1)
+                    fn(ids[i], values[i]);
+            }
+        }
+    }
+};
+
+/**
+ * @brief Publish sequence counter (odd while a frame is being published)
+ */
+#if defined(__AVR__)
+typedef uint8_t HWSequence; // single-byte loads are atomic on AVR
+#else
+typedef uint32_t HWSequence;
+#endif
+
+// HW_BARRIER() (hw_ring.h) orders bank writes against the publish sequence
+
+/**
+ * @brief Consistent copy of all sensors from one frame
+ *
+ * Filled by HWMonitorT::snapshot(). Safe to read from any task or core.
+ */
+template <uint8_t MaxSensors, typename IdType>
+struct HWSnapshotT
+{
+    IdType ids[MaxSensors];
+    float values[MaxSensors];
+    uint8_t valid[hwBitmaskSize(MaxSensors)];
+    uint8_t sensorCount;
+    uint32_t lastUpdate;
+    HWSequence sequence;
+
+    /**
+     * @brief Check if sensor at index has valid data
+     * @param index Sensor index (0 to sensorCount-1)
+     * @return true if sensor data is valid
+     */
+    bool isValid(uint8_t index) const
+    {
+        return index < sensorCount && hwBitTest(valid, index);
+    }
+
+    /**
+     * @brief Get sensor value by ID
+     * @param id Sensor ID
+     * @param defaultValue Value to return if sensor not found
+     * @return Sensor value or defaultValue
+     */
+    float get(HWSensorId id, float defaultValue = -999.0f) const
+    {
+        for (uint8_t i = 0; i < sensorCount; i++)
+        {
+            if (ids[i] == id && hwBitTest(valid, i))
+            {
+                return values[i];
+            }
+        }
+        return defaultValue;
+    }
+};
+
+/**
+ * @brief Resynchronization statistics
+ *
+ * A resync starts at the first framing error (bad version, count, END
+ * byte or CRC) and ends when the next frame is committed.
+ */
+struct HWResyncStats
+{
+    uint32_t events;     // Resyncs started
+    uint32_t lastBytes;  // Bytes discarded during the last resync
+    uint32_t maxBytes;   // Worst case bytes discarded
+    uint16_t lastFrames; // Rejected frame candidates during the last resync
+    uint16_t maxFrames;  // Worst case rejected frame candidates
+};
+
 /**
  * @brief Parser state machine states
  */
@@ -122,6 +476,10 @@ enum HWParserState
 {
     HW_STATE_IDLE,
     HW_STATE_VERSION,
+    HW_STATE_TYPE,
+    HW_STATE_SEQ,
+    HW_STATE_HASH_LOW,
+    HW_STATE_HASH_HIGH,
     HW_STATE_COUNT,
     HW_STATE_DATA,
     HW_STATE_CRC_LOW,
@@ -129,6 +487,32 @@ enum HWParserState
     HW_STATE_END
 };
 
+/**
+ * @brief How frames are delimited on the wire
+ */
+enum HWFraming
+{
+    HW_FRAMING_RAW,  // START/END bytes, resync by scanning for START
+    HW_FRAMING_COBS, // COBS-stuffed frames, resync at the next 0x00
+    HW_FRAMING_TEXT  // $S / ID:VALUE / $E:XX lines, resync at the next '$'
+};
+
+/**
+ * @brief Text framing parser states
+ */
+enum HWTextState
+{
+    HW_STATE_TEXT_IDLE,
+    HW_STATE_TEXT_START,  // '$' seen, expecting 'S'
+    HW_STATE_TEXT_HEADER, // rest of the $S line
+    HW_STATE_TEXT_LINE,   // start of a line inside a frame
+    HW_STATE_TEXT_ID,
+    HW_STATE_TEXT_VALUE,
+    HW_STATE_TEXT_MARK,   // '$' at the start of a line inside a frame
+    HW_STATE_TEXT_END_COLON,
+    HW_STATE_TEXT_CHECKSUM
+};
+
 /**
  * @brief Callback function type for new packet
  */
@@ -137,19 +521,224 @@ typedef void (*HWPacketCallback)(uint8_t sensorCount);
 /**
  * @brief Callback function type for sensor update
  */
-typedef void (*HWSensorCallback)(uint8_t id, float value);
+typedef void (*HWSensorCallback)(HWSensorId id, float value);
+
+/**
+ * @brief Callback storage, empty when HW_FEATURE_CALLBACKS is off
+ */
+template <bool Enabled, typename FrameCallback>
+struct HWCallbacks
+{
+    HWPacketCallback packet;
+    HWSensorCallback sensor;
+    HWSensorCallback change;
+    FrameCallback frame;
+
+    HWCallbacks() : packet(nullptr), sensor(nullptr), change(nullptr), frame(nullptr) {}
+};
+
+template <typename FrameCallback>
+struct HWCallbacks<false, FrameCallback>
+{
+    static constexpr HWPacketCallback packet = nullptr;
+    static constexpr HWSensorCallback sensor = nullptr;
+    static constexpr HWSensorCallback change = nullptr;
+    static constexpr FrameCallback frame = nullptr;
+};
+
+/*===========================================================================*/
+/*  LOOKUP INDEX                                                             */
+/*===========================================================================*/
+
+#define HW_INDEX_EMPTY 0xFF
+
+/**
+ * @brief Smallest power of two >= n
+ */
+constexpr uint16_t hwPow2Ceil(uint16_t n, uint16_t p = 1)
+{
+    return p >= n ? p : hwPow2Ceil(n, p * 2);
+}
+
+/**
+ * @brief hw_ring_t with its own storage
+ *
+ * Fill it from an ISR or receive callback, drain it with
+ * HWMonitorT::drain(). Also passes as a hw_ring_t to the C functions.
+ *
+ * @tparam Size Bytes, a power of two up to HW_RING_MAX_SIZE
+ */
+template <uint16_t Size>
+class HWRing : public hw_ring_t
+{
+    static_assert(Size >= 2 && (Size & (Size - 1)) == 0 && Size <= HW_RING_MAX_SIZE,
+                  "HWRing size must be a power of two up to HW_RING_MAX_SIZE");
+
+public:
+    HWRing() { hw_ring_init(this, _storage, Size); }
+
+    /** @brief Producer side, see hw_ring_write() */
+    size_t write(const uint8_t *data, size_t len) { return hw_ring_write(this, data, len); }
+    bool put(uint8_t byte) { return hw_ring_put(this, byte); }
+
+    /** @brief Bytes waiting for the parser */
+    size_t available() const { return hw_ring_count(this); }
+    size_t highWater() const { return high_water; }
+    uint32_t overflowed() const { return overflows; }
+
+private:
+    uint8_t _storage[Size];
+};
+
+/**
+ * @brief ID to slot index, open addressing with linear probing
+ *
+ * Holds only slot numbers; hits are confirmed against the ID array,
+ * so the table stays at one byte per bucket (load factor <= 0.5).
+ */
+template <typename IdType, uint16_t Capacity, bool Direct = (sizeof(IdType) == 1 && Capacity >= 64)>
+class HWSensorIndex
+{
+public:
+    static const uint16_t SIZE = hwPow2Ceil(Capacity * 2);
+
+    void clear()
+    {
+        memset(_slots, HW_INDEX_EMPTY, sizeof(_slots));
+    }
+
+    void build(const IdType *ids, uint8_t count)
+    {
+        clear();
+        for (uint8_t i = 0; i < count; i++)
+        {
+            uint16_t h = _hash(ids[i]);
+            while (_slots[h] != HW_INDEX_EMPTY)
+            {
+                if (ids[_slots[h]] == ids[i])
+                    break; // duplicate ID, first record wins
+                h = (h + 1) & (SIZE - 1);
+            }
+            if (_slots[h] == HW_INDEX_EMPTY)
+                _slots[h] = i;
+        }
+    }
+
+    uint8_t find(IdType id, const IdType *ids) const
+    {
+        uint16_t h = _hash(id);
+        uint8_t slot;
+        while ((slot = _slots[h]) != HW_INDEX_EMPTY)
+        {
+            if (ids[slot] == id)
+                return slot;
+            h = (h + 1) & (SIZE - 1);
+        }
+        return HW_INDEX_EMPTY;
+    }
+
+private:
+    uint8_t _slots[SIZE];
+
+    static uint16_t _hash(IdType id)
+    {
+        // Fibonacci hashing, top bits of the 16-bit product
+        return (uint16_t)((uint16_t)id * 40503u) >> (16 - _bits());
+    }
+
+    static constexpr uint8_t _bits(uint16_t n = SIZE, uint8_t b = 0)
+    {
+        return n <= 1 ? b : _bits(n >> 1, b + 1);
+    }
+};
+
+/**
+ * @brief Direct 256-entry table for 8-bit IDs, once hashing saves no RAM
+ */
+template <typename IdType, uint16_t Capacity>
+class HWSensorIndex<IdType, Capacity, true>
+{
+public:
+    void clear()
+    {
+        memset(_slots, HW_INDEX_EMPTY, sizeof(_slots));
+    }
+
+    void build(const IdType *ids, uint8_t count)
+    {
+        clear();
+        for (uint8_t i = count; i-- > 0;)
+        {
+            _slots[(uint8_t)ids[i]] = i; // first record wins
+        }
+    }
+
+    uint8_t find(IdType id, const IdType *ids) const
+    {
+        uint8_t slot = _slots[id];
+        return (slot != HW_INDEX_EMPTY && ids[slot] == id) ? slot : HW_INDEX_EMPTY;
+    }
+
+private:
+    uint8_t _slots[256];
+};
 
 /*===========================================================================*/
 /*  MAIN CLASS                                                               */
 /*===========================================================================*/
 
-class HWMonitor
+/**
+ * @brief Protocol parser with compile-time capacity and features
+ *
+ * @tparam MaxSensors Sensors kept (1 to 254), sizes every buffer. Frames
+ *         may carry more, the first MaxSensors are stored.
+ * @tparam IdType HWSensorId, or uint8_t for v1-style IDs only
+ * @tparam Features HW_FEATURE_* flags
+ */
+template <uint8_t MaxSensors, typename IdType = HWSensorId, uint16_t Features = HW_FEATURES_DEFAULT>
+class HWMonitorT
 {
+    static_assert(MaxSensors > 0 && MaxSensors < HW_INDEX_EMPTY, "MaxSensors must be 1..254");
+    static_assert((IdType)-1 > 0 && sizeof(IdType) <= sizeof(HWSensorId), "IdType must be uint8_t or uint16_t");
+    static_assert(!(Features & HW_FEATURE_SCALED) || (Features & HW_FEATURE_RESYNC), "HW_FEATURE_SCALED reads SCALE frames from the resync buffer");
+    static_assert(!(Features & HW_FEATURE_META) || (Features & HW_FEATURE_RESYNC), "HW_FEATURE_META reads META frames from the resync buffer");
+
 public:
+    static const bool HAS_CRC = (Features & HW_FEATURE_CRC) != 0;
+    static const bool HAS_TIMESTAMPS = (Features & HW_FEATURE_TIMESTAMPS) != 0;
+    static const bool HAS_CALLBACKS = (Features & HW_FEATURE_CALLBACKS) != 0;
+    static const bool HAS_RESYNC = (Features & HW_FEATURE_RESYNC) != 0;
+    static const bool HAS_SCALED = (Features & HW_FEATURE_SCALED) != 0;
+    static const bool HAS_COBS = (Features & HW_FEATURE_COBS) != 0;
+    static const bool HAS_SCHEMA = (Features & HW_FEATURE_SCHEMA) != 0;
+    static const bool HAS_META = (Features & HW_FEATURE_META) != 0;
+    static const bool HAS_DEADBAND = (Features & HW_FEATURE_DEADBAND) != 0;
+    static const bool HAS_TEXT = (Features & HW_FEATURE_TEXT) != 0;
+
+    // Largest frame this instance buffers, stuffed size for COBS, or
+    // 1 byte when neither resync nor COBS needs the buffer. Raw frames
+    // with more records stream through; only their lookback is lost.
+    static const uint16_t DATA_FRAME_SIZE = HW_HEADER_SIZE_V3 + 3 + (uint16_t)MaxSensors * HW_RECORD_SIZE_V2;
+    static const uint16_t SCALE_FRAME_SIZE = HAS_SCALED ? HW_HEADER_SIZE_V3 + 3 + HW_SCALE_RECORDS * HW_RECORD_SIZE_SCALE : 0;
+    static const uint16_t META_FRAME_SIZE = HAS_META ? HW_HEADER_SIZE_V3 + 3 + HW_META_RECORDS * HW_RECORD_SIZE_META : 0;
+    static const uint16_t TABLE_FRAME_SIZE = SCALE_FRAME_SIZE > META_FRAME_SIZE ? SCALE_FRAME_SIZE : META_FRAME_SIZE;
+    static const uint16_t FRAME_SIZE = DATA_FRAME_SIZE > TABLE_FRAME_SIZE ? DATA_FRAME_SIZE : TABLE_FRAME_SIZE;
+    static const uint16_t RX_FRAME_SIZE = HAS_COBS ? FRAME_SIZE + FRAME_SIZE / 254 + 1 : FRAME_SIZE;
+    static const uint16_t RX_BUFFER_SIZE = !(HAS_RESYNC || HAS_COBS) ? 1 : RX_FRAME_SIZE < HW_RX_BUFFER_SIZE ? RX_FRAME_SIZE : HW_RX_BUFFER_SIZE;
+
+    static const size_t SUBSCRIBE_FRAME_SIZE = HW_HEADER_SIZE_V3 + HW_MAX_SUBSCRIBE * HW_RECORD_SIZE_ID + 3;
+    static const size_t SUBSCRIBE_MAX_SIZE = SUBSCRIBE_FRAME_SIZE + SUBSCRIBE_FRAME_SIZE / 254 + 2; // COBS, with delimiter
+
+    typedef HWSensorT<IdType> Sensor;
+    typedef HWSensorView<Sensor> SensorView;
+    typedef HWSnapshotT<MaxSensors, IdType> Snapshot;
+    typedef HWFrameViewT<IdType> FrameView;
+    typedef void (*FrameCallback)(const FrameView &frame);
+
     /**
      * @brief Constructor
      */
-    HWMonitor();
+    HWMonitorT();
 
     /**
      * @brief Initialize the monitor
@@ -161,13 +750,132 @@ public:
      */
     void reset();
 
+    /**
+     * @brief Select the wire framing, the host must use the same one
+     * @param framing HW_FRAMING_RAW (default), HW_FRAMING_COBS or HW_FRAMING_TEXT
+     * @return false if the framing's feature (HW_FEATURE_COBS, HW_FEATURE_TEXT)
+     *         is disabled
+     */
+    bool setFraming(HWFraming framing);
+
+    /**
+     * @brief Get the wire framing
+     */
+    HWFraming framing() const { return _framing; }
+
     /**
      * @brief Update from a Stream (Serial, etc.)
+     *
+     * With flow control enabled, also writes an ACK or NACK back to the
+     * stream after frames were received or rejected.
+     *
      * @param stream Reference to input stream
      * @return true if a complete packet was parsed
      */
     bool update(Stream &stream);
 
+    /**
+     * @brief Update from a Stream, then pass the frame to fn
+     *
+     * Inlinable variant of onFrame(). fn(const FrameView &) runs once after
+     * the stream is drained, not once per frame. If several frames arrived,
+     * changed covers all of them.
+     *
+     * @return true if a complete packet was parsed
+     */
+    template <typename Fn>
+    bool update(Stream &stream, Fn &&fn)
+    {
+        return _dispatch(update(stream), fn);
+    }
+
+    /**
+     * @brief Update from a Stream for at most budgetUs microseconds
+     *
+     * Same as update(), but stops reading once the budget is spent. At
+     * least one chunk is read; the rest waits in the Stream's buffer.
+     *
+     * @param stream Reference to input stream
+     * @param budgetUs Time limit, 0 reads until the stream is empty
+     * @return true if a complete packet was parsed
+     */
+    bool poll(Stream &stream, uint32_t budgetUs);
+
+    /**
+     * @brief Time-bounded update, then pass the frame to fn as update() does
+     */
+    template <typename Fn>
+    bool poll(Stream &stream, uint32_t budgetUs, Fn &&fn)
+    {
+        return _dispatch(poll(stream, budgetUs), fn);
+    }
+
+    /**
+     * @brief Parse bytes a receive callback left in a ring
+     *
+     * Decouples receiving from parsing: an ISR or USB callback writes
+     * into the ring, the loop or a task drains it here in bounded batches,
+     * parsing straight from the ring storage. Sends no ACKs or
+     * subscriptions; write statusFrame() and subscriptionFrame() yourself.
+     *
+     * @param ring Filled by exactly one producer, drained only here
+     * @param maxBytes Most bytes to parse in this call
+     * @return true if a complete packet was parsed
+     */
+    bool drain(hw_ring_t &ring, size_t maxBytes = HW_RING_BATCH_SIZE);
+
+    /**
+     * @brief Drain a ring, then pass the frame to fn as update() does
+     */
+    template <typename Fn>
+    bool drain(hw_ring_t &ring, size_t maxBytes, Fn &&fn)
+    {
+        return _dispatch(drain(ring, maxBytes), fn);
+    }
+
+    /**
+     * @brief Grant the host receive credits from update()
+     *
+     * The host stops sending once `window` frames are unacknowledged and
+     * coalesces its data until the next ACK. Needs v3 frames; a host that
+     * never reads the ACKs is unaffected.
+     *
+     * @param window Frames in flight, 0 turns flow control off
+     */
+    void enableFlowControl(uint8_t window = HW_FLOW_WINDOW);
+
+    /**
+     * @brief Build the ACK (or NACK while needsKeyframe()) for the last frame
+     * @param out At least HW_STATUS_MAX_SIZE bytes
+     * @return Bytes written, in the current framing
+     */
+    size_t statusFrame(uint8_t *out) const;
+
+    /**
+     * @brief Ask the host to send only these sensors
+     *
+     * update() advertises the set after the next received frame, then
+     * repeats it every HW_SUBSCRIBE_INTERVAL_MS so a restarted host picks
+     * it up. Until then the host sends everything it has selected.
+     *
+     * @param ids Sensor IDs, copied
+     * @param count At most HW_MAX_SUBSCRIBE, 0 asks for every sensor again
+     * @return false if count is too large
+     */
+    bool subscribe(const IdType *ids, uint8_t count);
+
+    /**
+     * @brief Number of subscribed IDs, 0 when the host sends everything
+     */
+    uint8_t subscribedCount() const { return _subCount; }
+
+    /**
+     * @brief Build the SUBSCRIBE frame for the current interest set
+     * @param out At least SUBSCRIBE_MAX_SIZE bytes
+     * @return Bytes written, in the current framing
+     */
+    size_t subscriptionFrame(uint8_t *out) const;
+
     /**
      * @brief Process a single byte
      * @param byte Incoming byte
@@ -176,47 +884,158 @@ public:
     bool processByte(uint8_t byte);
 
     /**
-     * @brief Parse a complete buffer
+     * @brief Process a chunk of stream data
+     *
+     * Same state machine as processByte(), but skips to the next START
+     * byte with memchr() and decodes whole records straight from the
+     * chunk. Frames may be split across calls.
+     *
      * @param data Pointer to data
      * @param len Length of data
-     * @return true if valid packet was parsed
+     * @return true if at least one complete packet was parsed
+     */
+    bool feed(const uint8_t *data, size_t len);
+
+    /**
+     * @brief Process a chunk, then pass the frame to fn as update() does
+     */
+    template <typename Fn>
+    bool feed(const uint8_t *data, size_t len, Fn &&fn)
+    {
+        return _dispatch(feed(data, len), fn);
+    }
+
+    /**
+     * @brief Parse a complete buffer (v1, v2 and v3 frames)
+     * @param data Pointer to data
+     * @param len Length of data
+     * @return true if at least one valid packet was parsed
      */
     bool parse(const uint8_t *data, size_t len);
 
+    /**
+     * @brief Parse every complete frame in a buffer, in place
+     *
+     * Bytes after *consumed start an incomplete frame. Keep them and
+     * call again once more data has been appended.
+     *
+     * @param data Pointer to data
+     * @param len Length of data
+     * @param consumed Optional, receives number of bytes consumed
+     * @return Number of valid packets parsed
+     */
+    size_t parseFrames(const uint8_t *data, size_t len, size_t *consumed = nullptr);
+
     /**
      * @brief Get sensor value by ID
+     *
+     * Safe from another task, like isValid() and findSensor(): the lookup
+     * is retried if a frame is published meanwhile. Values from separate
+     * calls may still come from different frames, use snapshot() for that.
+     *
      * @param id Sensor ID
      * @param defaultValue Value to return if sensor not found
      * @return Sensor value or defaultValue
      */
-    float get(uint8_t id, float defaultValue = -999.0f) const;
+    float get(HWSensorId id, float defaultValue = -999.0f) const;
 
     /**
      * @brief Check if sensor has valid data
      * @param id Sensor ID
      * @return true if sensor data is valid
      */
-    bool isValid(uint8_t id) const;
+    bool isValid(HWSensorId id) const;
 
     /**
      * @brief Get sensor by index
      * @param index Sensor index (0 to sensorCount-1)
-     * @return Pointer to sensor or nullptr
+     * @return View of the sensor, false if index is out of range
      */
-    const HWSensor *getSensorByIndex(uint8_t index) const;
+    SensorView getSensorByIndex(uint8_t index) const;
 
     /**
      * @brief Find sensor by ID
      * @param id Sensor ID
-     * @return Pointer to sensor or nullptr
+     * @return View of the sensor, false if not found
      */
-    const HWSensor *findSensor(uint8_t id) const;
+    SensorView findSensor(HWSensorId id) const;
 
     /**
      * @brief Invalidate all sensors (call on timeout)
      */
     void invalidateAll();
 
+    /**
+     * @brief Copy the last published frame without locking
+     *
+     * For readers on another task or core. The parser never waits for
+     * readers; the copy is retried if a frame is published meanwhile.
+     *
+     * @param out Destination snapshot
+     * @param maxRetries Attempts before giving up
+     * @return true if out holds a consistent frame
+     */
+    bool snapshot(Snapshot &out, uint8_t maxRetries = 8) const;
+
+    /**
+     * @brief Check if values may be stale after lost delta frames
+     * @return true until a keyframe (or v1/v2 frame) has been received
+     *         since the last gap in the v3 frame sequence
+     */
+    bool needsKeyframe() const { return _needKeyframe; }
+
+    /**
+     * @brief Get the scale received for a sensor
+     * @param id Sensor ID
+     * @param scale Receives the multiplier for int16 values
+     * @param offset Receives the offset added after scaling
+     * @return true if a SCALE frame has covered this ID
+     */
+    bool getScale(HWSensorId id, float &scale, float &offset) const;
+
+    /**
+     * @brief Get the hash of the cached schema
+     * @return Hash VALUES frames must carry, or 0 before any SCHEMA frame
+     */
+    uint16_t schemaHash() const { return _schemaValid ? _schemaHash : 0; }
+
+    /**
+     * @brief Get the sensor name from META frames
+     * @param id Sensor ID
+     * @return Host's name, or hwGetSensorName() before any META frame
+     */
+    const char *getName(HWSensorId id) const;
+
+    /**
+     * @brief Get the sensor unit from META frames
+     * @param id Sensor ID
+     * @return Host's unit, or hwGetSensorUnit() before any META frame
+     */
+    const char *getUnit(HWSensorId id) const;
+
+    /**
+     * @brief Resolve a role to the ID the host assigned it
+     *
+     * The convenience getters go through this, a table lookup.
+     *
+     * @param role Fixed SENSOR_* ID, e.g. SENSOR_CPU_TEMP
+     * @return Bound ID; role itself before any META frame, or
+     *         SENSOR_UNKNOWN if the host bound no sensor to it
+     */
+    HWSensorId roleId(HWSensorId role) const;
+
+    /**
+     * @brief Get the number of sensors described by META frames
+     */
+    uint8_t metaCount() const { return _metaCount; }
+
+    /**
+     * @brief Get publish sequence number
+     * @return Counter that changes every time a frame is published or a
+     *         META frame rebinds roles
+     */
+    HWSequence sequence() const { return _seq; }
+
     /**
      * @brief Check if data is stale
      * @param timeoutMs Timeout in milliseconds
@@ -242,77 +1061,793 @@ public:
      */
     void onSensor(HWSensorCallback callback);
 
+    /**
+     * @brief Set callback for each validated frame
+     *
+     * One call per frame instead of one per sensor. The view covers the
+     * whole table, changed is changedMask().
+     *
+     * @param callback Function to call with the committed frame
+     */
+    void onFrame(FrameCallback callback);
+
+    /**
+     * @brief Set callback for sensors that changed
+     *
+     * Like onSensor(), but skips sensors whose value stayed within their
+     * deadband.
+     *
+     * @param callback Function to call for each changed sensor
+     */
+    void onChange(HWSensorCallback callback);
+
+    /**
+     * @brief Ignore changes of one sensor smaller than a deadband
+     *
+     * A sensor counts as changed once it is more than
+     * max(absolute, relative * |last|) away from the last value it was
+     * reported with. ID rules take precedence over category rules; an
+     * existing rule for the same ID is replaced.
+     *
+     * @param id Sensor ID
+     * @param absolute Smallest change reported, in the sensor's unit
+     * @param relative Smallest change reported, as a fraction of the value
+     * @return false if HW_MAX_DEADBANDS rules are already set
+     */
+    bool setDeadband(HWSensorId id, float absolute, float relative = 0.0f);
+
+    /**
+     * @brief Deadband for every sensor of a category
+     *
+     * Sensors with host-assigned IDs are matched by their META role.
+     *
+     * @param category HW_CATEGORY_CPU, HW_CATEGORY_GPU...
+     * @return false if HW_MAX_DEADBANDS rules are already set
+     */
+    bool setCategoryDeadband(uint8_t category, float absolute, float relative = 0.0f);
+
+    /**
+     * @brief Remove all deadband rules, every new value counts as a change
+     */
+    void clearDeadbands();
+
+    /**
+     * @brief Sensors that changed in the last committed frame
+     *
+     * Bit per slot (getSensorByIndex() order). Set for sensors that became
+     * valid or moved past their deadband, or for every sensor the frame
+     * carried without HW_FEATURE_DEADBAND. Unchanged values never set it,
+     * so redrawing or logging only these costs work per real change.
+     */
+    const uint8_t *changedMask() const { return _moved; }
+
+    /**
+     * @brief Check changedMask() for one sensor
+     * @param index Sensor index (0 to sensorCount-1)
+     */
+    bool isChanged(uint8_t index) const { return index < sensorCount && hwBitTest(_moved, index); }
+
     // Convenience getters
-    inline float getCpuTemp() const { return get(SENSOR_CPU_TEMP); }
-    inline float getCpuLoad() const { return get(SENSOR_CPU_LOAD); }
-    inline float getCpuClock() const { return get(SENSOR_CPU_CLOCK); }
-    inline float getCpuPower() const { return get(SENSOR_CPU_POWER); }
+    inline float getCpuTemp() const { return get(roleId(SENSOR_CPU_TEMP)); }
+    inline float getCpuLoad() const { return get(roleId(SENSOR_CPU_LOAD)); }
+    inline float getCpuClock() const { return get(roleId(SENSOR_CPU_CLOCK)); }
+    inline float getCpuPower() const { return get(roleId(SENSOR_CPU_POWER)); }
 
-    inline float getGpuTemp() const { return get(SENSOR_GPU_TEMP); }
-    inline float getGpuLoad() const { return get(SENSOR_GPU_LOAD); }
-    inline float getGpuClock() const { return get(SENSOR_GPU_CLOCK); }
-    inline float getGpuPower() const { return get(SENSOR_GPU_POWER); }
-    inline float getGpuFan() const { return get(SENSOR_GPU_FAN); }
-    inline float getGpuHotspot() const { return get(SENSOR_GPU_HOTSPOT); }
-    inline float getGpuMemLoad() const { return get(SENSOR_GPU_LOAD_MEM); }
+    inline float getGpuTemp() const { return get(roleId(SENSOR_GPU_TEMP)); }
+    inline float getGpuLoad() const { return get(roleId(SENSOR_GPU_LOAD)); }
+    inline float getGpuClock() const { return get(roleId(SENSOR_GPU_CLOCK)); }
+    inline float getGpuPower() const { return get(roleId(SENSOR_GPU_POWER)); }
+    inline float getGpuFan() const { return get(roleId(SENSOR_GPU_FAN)); }
+    inline float getGpuHotspot() const { return get(roleId(SENSOR_GPU_HOTSPOT)); }
+    inline float getGpuMemLoad() const { return get(roleId(SENSOR_GPU_LOAD_MEM)); }
 
-    inline float getRamUsed() const { return get(SENSOR_RAM_USED); }
-    inline float getRamLoad() const { return get(SENSOR_RAM_LOAD); }
+    inline float getRamUsed() const { return get(roleId(SENSOR_RAM_USED)); }
+    inline float getRamLoad() const { return get(roleId(SENSOR_RAM_LOAD)); }
 
-    inline float getDiskTemp() const { return get(SENSOR_DISK_TEMP); }
-    inline float getDiskLoad() const { return get(SENSOR_DISK_LOAD); }
+    inline float getDiskTemp() const { return get(roleId(SENSOR_DISK_TEMP)); }
+    inline float getDiskLoad() const { return get(roleId(SENSOR_DISK_LOAD)); }
 
-    inline float getNetUp() const { return get(SENSOR_NET_UP); }
-    inline float getNetDown() const { return get(SENSOR_NET_DOWN); }
+    inline float getNetUp() const { return get(roleId(SENSOR_NET_UP)); }
+    inline float getNetDown() const { return get(roleId(SENSOR_NET_DOWN)); }
 
     // Statistics
     uint32_t packetsOK;
     uint32_t packetsError;
+    uint32_t crcErrors;
+    uint32_t deltasMissed; // v3 frames lost before a delta
+    uint32_t scaleMisses;  // int16 values dropped for lack of a scale
+    uint32_t schemaMisses; // VALUES frames dropped for lack of their schema
     uint8_t sensorCount;
     uint32_t lastUpdate;
+    HWResyncStats resync;
 
 private:
-    HWSensor _sensors[HW_MAX_SENSORS];
+    enum StepResult
+    {
+        STEP_CONTINUE,
+        STEP_FRAME,
+        STEP_ERROR
+    };
+
+    enum FrameCheck
+    {
+        FRAME_OK,
+        FRAME_INCOMPLETE,
+        FRAME_BAD
+    };
+
+    static const uint8_t VALID_BYTES = hwBitmaskSize(MaxSensors);
+
+    // Front bank is published to readers, frames are decoded into the back.
+    // Per-sensor stamps shrink to one unused entry without HW_FEATURE_TIMESTAMPS.
+    IdType _ids[2][MaxSensors];
+    float _values[2][MaxSensors];
+    uint8_t _valid[2][VALID_BYTES];
+    uint32_t _stamps[2][HAS_TIMESTAMPS ? MaxSensors : 1];
+    uint8_t _bankCount[2];
+    uint32_t _bankTime[2];
+    volatile uint8_t _front;
+    volatile HWSequence _seq;
+
+    // One per bank, rebuilt only when a frame changes the ID layout. The
+    // front index is never written, so lookups from another task cannot
+    // miss an ID while the back bank is relaid out.
+    HWSensorIndex<IdType, MaxSensors> _index[2];
+    bool _indexStale; // back index still has the layout before the last relayout
+
+    // Sensors written by the frame in progress
+    uint8_t _updated[VALID_BYTES];
+
+    // Scales for int16 values, by ID. Only the parser uses them, so
+    // they are not double-buffered.
+    static const uint8_t SCALE_CAPACITY = HAS_SCALED ? MaxSensors : 1;
+    IdType _scaleIds[SCALE_CAPACITY];
+    float _scaleMul[SCALE_CAPACITY];
+    float _scaleAdd[SCALE_CAPACITY];
+    uint8_t _scaleCount;
+    HWSensorIndex<IdType, SCALE_CAPACITY> _scaleIndex;
+
+    // ID order for VALUES frames, the first MaxSensors positions kept.
+    // Narrow instances also drop IDs they cannot store, _schemaKeep then
+    // marks which positions are kept (_schemaNext while SCHEMA decodes).
+    static const uint8_t SCHEMA_CAPACITY = HAS_SCHEMA ? MaxSensors : 1;
+    static const bool SCHEMA_NARROW = HAS_SCHEMA && sizeof(IdType) < sizeof(HWSensorId);
+    static const uint8_t SCHEMA_KEEP_BYTES = SCHEMA_NARROW ? hwBitmaskSize(HW_MAX_RECORDS) : 1;
+    IdType _schemaIds[SCHEMA_CAPACITY];
+    uint8_t _schemaKeep[SCHEMA_KEEP_BYTES];
+    uint8_t _schemaNext[SCHEMA_KEEP_BYTES];
+    uint8_t _schemaSize;  // positions in VALUES frames
+    uint8_t _schemaCount; // IDs kept
+    uint16_t _schemaHash;
+    uint16_t _schemaCrc; // hash of the SCHEMA frame in progress
+    bool _schemaValid;
+    bool _schemaDense;
+    bool _schemaMiss; // VALUES frame in progress does not match the schema
+
+    // Metadata: arena offsets per described ID, and the ID bound to each role
+    static const uint8_t META_CAPACITY = HAS_META ? MaxSensors : 1;
+    static const uint16_t META_ARENA = HAS_META ? HW_META_ARENA_SIZE : 1;
+    static const uint8_t ROLE_CAPACITY = HAS_META ? HW_ROLE_COUNT : 1;
+    static const uint16_t META_NONE = 0xFFFF; // string did not fit the arena
+    IdType _metaIds[META_CAPACITY];
+    uint16_t _metaName[META_CAPACITY];
+    uint16_t _metaUnit[META_CAPACITY];
+    uint8_t _metaCount;
+    HWSensorIndex<IdType, META_CAPACITY> _metaIndex;
+    HWSensorId _roleIds[ROLE_CAPACITY];
+    char _metaArena[META_ARENA];
+    uint16_t _metaArenaLen;
+    bool _metaValid;
+
+    HWFraming _framing;
     HWParserState _state;
+    uint8_t _version;
+    uint8_t _frameVersion;
+    uint8_t _frameType;
+    uint8_t _encoding;
+    uint8_t _frameSeq;
+    uint16_t _frameHash;
+    uint8_t _lastSeq;
+    bool _seqValid;
+    bool _needKeyframe;
+    uint8_t _recordSize;
     uint8_t _expectedCount;
     uint8_t _currentSensor;
-    uint8_t _byteInSensor;
-    uint8_t _tempId;
-    uint8_t _tempValue[4];
+    uint8_t _storedCount; // records kept, lower than _currentSensor if IDs were dropped
+    uint8_t _byteInRecord;
+    uint8_t _record[HW_MAX_RECORD_SIZE];
     uint8_t _crcLow;
-    uint8_t _crcHigh;
+    uint16_t _crcReceived;
+    uint16_t _crc;
+
+    // Raw bytes of the frame in progress, replayed after a framing error.
+    // With COBS framing it collects a stuffed frame, decoded in place.
+    uint8_t _rxBuffer[RX_BUFFER_SIZE];
+    size_t _rxLen;
+    bool _rxOverflow;
+    bool _resyncPending;
+    uint32_t _resyncBytes;
+    uint16_t _resyncFrames;
+
+    // Text framing: position in the line grammar, running XOR, and the
+    // record being read. Values accumulate as decimal digits, so nothing
+    // is buffered.
+    HWTextState _textState;
+    uint8_t _textSum;
+    uint8_t _textCheck;
+    uint8_t _textLine;   // bytes in the current line
+    uint8_t _textDigits; // significant digits in _textMant
+    int8_t _textExp;     // value = _textMant * 10^_textExp
+    uint8_t _textFlags;
+    uint16_t _textId;
+    uint32_t _textMant;
+
+    static const uint8_t TEXT_NEG = 0x01;
+    static const uint8_t TEXT_SIGN = 0x02;
+    static const uint8_t TEXT_POINT = 0x04;
+    static const uint8_t TEXT_DIGIT = 0x08;
+    static const uint8_t TEXT_BAD = 0x10; // record is dropped at its newline
+
+    // Flow control, _flowErrors is packetsError at the last status frame
+    uint8_t _flowWindow;
+    uint32_t _flowErrors;
+
+    // Interest set, _subActive until an empty set has been advertised once
+    IdType _subIds[HW_MAX_SUBSCRIBE];
+    uint8_t _subCount;
+    bool _subActive;
+    bool _subPending;
+    uint32_t _subTime;
+
+    // Deadbands: value each slot was last reported with, and its rule
+    static const uint8_t BAND_CAPACITY = HAS_DEADBAND ? MaxSensors : 1;
+    float _reported[BAND_CAPACITY];
+    uint8_t _bandOf[BAND_CAPACITY]; // rule index, HW_INDEX_EMPTY for none
+    HWDeadband _bands[HAS_DEADBAND ? HW_MAX_DEADBANDS : 1];
+    uint8_t _bandCount;
+    bool _bandsDirty; // rules, layout or roles changed since _bandOf was built
+
+    // Slots changed by the last frame, and since the last functor dispatch
+    uint8_t _moved[VALID_BYTES];
+    uint8_t _changed[VALID_BYTES];
+
+    HWCallbacks<HAS_CALLBACKS, FrameCallback> _callbacks;
+
+    StepResult _step(uint8_t byte);
+    void _beginFrame(uint8_t version);
+    void _decodeRecord(uint8_t version, const uint8_t *record);
+    void _decodeValues(const uint8_t *data, uint8_t count);
+    bool _decodeValue(IdType id, const uint8_t *data, float &value);
+    bool _schemaKept(uint8_t position) const;
+    void _store(IdType id, float value);
+    bool _stepText(uint8_t byte);
+    bool _feedText(const uint8_t *data, size_t len);
+    void _textValue(uint8_t byte);
+    void _textRecord();
+    void _textError(uint8_t byte);
+    bool _commitFrame(const uint8_t *frame);
+    bool _applyScales(const uint8_t *frame);
+    bool _applyMeta(const uint8_t *frame);
+    void _detectChanges(uint8_t count, bool relayout);
+    void _assignBands(uint8_t bank, uint8_t count);
+    bool _addDeadband(HWSensorId id, uint8_t category, float absolute, float relative);
+    uint8_t _category(HWSensorId id) const;
+
+    FrameView _frameView(const uint8_t *changed) const
+    {
+        FrameView view;
+        view.ids = _ids[_front];
+        view.values = _values[_front];
+        view.changed = changed;
+        view.count = _bankCount[_front];
+        return view;
+    }
+
+    template <typename Fn>
+    bool _dispatch(bool packetReceived, Fn &fn)
+    {
+        if (packetReceived)
+        {
+            fn(_frameView(_changed));
+            memset(_changed, 0, VALID_BYTES);
+        }
+        return packetReceived;
+    }
+    uint16_t _intern(const uint8_t *text, uint8_t size);
+    void _clearMeta();
+    void _trackSequence();
+    uint8_t _slot(HWSensorId id, uint8_t bank) const;
+    SensorView _view(uint8_t bank, uint8_t slot) const;
+    template <typename Read>
+    bool _read(Read &&read) const;
+    void _publish(uint8_t count, uint32_t now);
+    FrameCheck _checkFrame(const uint8_t *pkt, size_t avail, size_t *frameLen);
+    bool _decodeFrame(const uint8_t *pkt);
+    void _capture(const uint8_t *data, size_t len);
+    void _countDiscarded(size_t len);
+    void _beginResync();
+    bool _resync();
+    bool _cobsFrame(const uint8_t *src, size_t len);
+};
+
+/**
+ * @brief Default monitor used by existing sketches
+ */
+typedef HWMonitorT<HW_MAX_SENSORS> HWMonitor;
+typedef HWMonitor::Snapshot HWSnapshot;
+
+/*===========================================================================*/
+/*  MULTIPLE SOURCES                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief Several senders, one parser per Stream, read as one store
+ *
+ * Each source (a UART or CDC port, one PC each) keeps its own parser,
+ * sensors, statistics and timeout, so memory grows by one HWMonitorT per
+ * source. Sensors are addressed by (source, id); IDs from different PCs
+ * never collide.
+ *
+ *   HWMultiMonitorT<3, 64> rack;
+ *   rack.attach(0, Serial1);
+ *   rack.attach(1, Serial2);
+ *   rack.onFrame(onRackFrame);           // (source, frame)
+ *   loop(): rack.poll();                 // at most HW_POLL_BUDGET_US
+ *           float t = rack.get(1, rack.monitor(1).roleId(SENSOR_CPU_TEMP));
+ */
+template <uint8_t Sources, uint8_t MaxSensors, typename IdType = HWSensorId, uint16_t Features = HW_FEATURES_DEFAULT>
+class HWMultiMonitorT
+{
+    static_assert(Sources > 0, "Sources must be at least 1");
+
+public:
+    typedef HWMonitorT<MaxSensors, IdType, Features> Monitor;
+    typedef typename Monitor::Sensor Sensor;
+    typedef typename Monitor::SensorView SensorView;
+    typedef typename Monitor::FrameView FrameView;
+    typedef void (*FrameCallback)(uint8_t source, const FrameView &frame);
+
+    HWMultiMonitorT() : _next(0), _onFrame(nullptr)
+    {
+        for (uint8_t s = 0; s < Sources; s++)
+            _streams[s] = nullptr;
+    }
+
+    /**
+     * @brief Initialize every parser
+     */
+    void begin()
+    {
+        for (uint8_t s = 0; s < Sources; s++)
+            _monitors[s].begin();
+    }
+
+    /**
+     * @brief Read a source from this stream, nullptr detaches it
+     * @return false if source is out of range
+     */
+    bool attach(uint8_t source, Stream *stream)
+    {
+        if (source >= Sources)
+            return false;
+        _streams[source] = stream;
+        return true;
+    }
 
-    HWPacketCallback _packetCallback;
-    HWSensorCallback _sensorCallback;
+    bool attach(uint8_t source, Stream &stream) { return attach(source, &stream); }
 
-    void _storeSensor();
-    bool _finalizePacket();
-    uint16_t _calculateCRC(const uint8_t *data, size_t len) const;
+    /**
+     * @brief Parser of one source: framing, deadbands, statistics
+     *
+     * Its own onFrame()/onSensor() callbacks still fire, without the source.
+     */
+    Monitor &monitor(uint8_t source) { return _monitors[source]; }
+    const Monitor &monitor(uint8_t source) const { return _monitors[source]; }
+
+    /**
+     * @brief Read every attached source within a time budget
+     *
+     * Visits the sources round-robin, starting one further each call. Each
+     * gets an equal share of the time still left, so idle ports hand their
+     * share to busy ones and no port can hold the loop for the whole budget
+     * while another waits. A source whose turn comes after the budget ran
+     * out is first in line next call.
+     *
+     * @param budgetUs Time for all sources together
+     * @return true if any source completed a packet
+     */
+    bool poll(uint32_t budgetUs = HW_POLL_BUDGET_US)
+    {
+        bool packetReceived = false;
+        uint32_t start = micros();
+        uint8_t first = _next;
+
+        _next = first + 1 < Sources ? first + 1 : 0;
+
+        // Shares are split among attached sources only
+        uint8_t left = 0;
+        for (uint8_t s = 0; s < Sources; s++)
+        {
+            if (_streams[s])
+                left++;
+        }
+
+        for (uint8_t n = 0; n < Sources; n++)
+        {
+            uint8_t s = first + n < Sources ? first + n : first + n - Sources;
+            if (!_streams[s])
+                continue;
+
+            uint32_t used = micros() - start;
+            if (used >= budgetUs)
+            {
+                _next = s;
+                break;
+            }
+
+            uint32_t slice = (budgetUs - used) / left--;
+            if (_monitors[s].poll(*_streams[s], slice ? slice : 1, [this, s](const FrameView &frame) {
+                    if (_onFrame)
+                        _onFrame(s, frame);
+                }))
+            {
+                packetReceived = true;
+            }
+        }
+
+        return packetReceived;
+    }
+
+    /**
+     * @brief Called with the source after a poll() turn that completed a
+     *        frame, once per turn as with HWMonitorT::update(stream, fn)
+     */
+    void onFrame(FrameCallback callback) { _onFrame = callback; }
+
+    /**
+     * @brief Get sensor value by source and ID
+     */
+    float get(uint8_t source, HWSensorId id, float defaultValue = -999.0f) const
+    {
+        return source < Sources ? _monitors[source].get(id, defaultValue) : defaultValue;
+    }
+
+    bool isValid(uint8_t source, HWSensorId id) const
+    {
+        return source < Sources && _monitors[source].isValid(id);
+    }
+
+    SensorView findSensor(uint8_t source, HWSensorId id) const
+    {
+        return source < Sources ? _monitors[source].findSensor(id) : SensorView();
+    }
+
+    /**
+     * @brief Call fn(source, sensor) for every valid sensor of every source
+     */
+    template <typename Fn>
+    void forEach(Fn &&fn) const
+    {
+        for (uint8_t s = 0; s < Sources; s++)
+        {
+            for (uint8_t i = 0; i < _monitors[s].sensorCount; i++)
+            {
+                SensorView sensor = _monitors[s].getSensorByIndex(i);
+                if (sensor && sensor->valid)
+                    fn(s, *sensor);
+            }
+        }
+    }
+
+    /**
+     * @brief Check if one source has gone quiet
+     */
+    bool isStale(uint8_t source, uint32_t timeoutMs = HW_TIMEOUT_MS) const
+    {
+        return source >= Sources || _monitors[source].isStale(timeoutMs);
+    }
+
+    /**
+     * @brief Milliseconds since the last packet of one source
+     */
+    uint32_t getAge(uint8_t source) const
+    {
+        return source < Sources ? _monitors[source].getAge() : UINT32_MAX;
+    }
+
+    /**
+     * @brief Sources that sent a packet within timeoutMs
+     */
+    uint8_t freshCount(uint32_t timeoutMs = HW_TIMEOUT_MS) const
+    {
+        uint8_t fresh = 0;
+        for (uint8_t s = 0; s < Sources; s++)
+            fresh += !_monitors[s].isStale(timeoutMs);
+        return fresh;
+    }
+
+    /**
+     * @brief Invalidate the sensors of every source that timed out
+     * @return Number of stale sources
+     */
+    uint8_t invalidateStale(uint32_t timeoutMs = HW_TIMEOUT_MS)
+    {
+        uint8_t stale = 0;
+        for (uint8_t s = 0; s < Sources; s++)
+        {
+            if (_monitors[s].isStale(timeoutMs))
+            {
+                _monitors[s].invalidateAll();
+                stale++;
+            }
+        }
+        return stale;
+    }
+
+    static uint8_t sourceCount() { return Sources; }
+
+private:
+    Monitor _monitors[Sources];
+    Stream *_streams[Sources];
+    uint8_t _next;
+    FrameCallback _onFrame;
 };
 
 /*===========================================================================*/
 /*  UTILITY FUNCTIONS                                                        */
 /*===========================================================================*/
 
+/**
+ * @brief Get record size for a protocol version
+ * @param version Version byte from frame header
+ * @param type TYPE byte of v3 frames, ignored for v1 and v2
+ * @return Bytes per sensor record, or 0 if version or type is unsupported
+ */
+inline uint8_t hwRecordSize(uint8_t version, uint8_t type = HW_FRAME_KEYFRAME)
+{
+    switch (version)
+    {
+    case HW_PROTO_VERSION_V1:
+        return HW_RECORD_SIZE_V1;
+    case HW_PROTO_VERSION_V2:
+        return HW_RECORD_SIZE_V2;
+    case HW_PROTO_VERSION_V3:
+        switch (type)
+        {
+        case HW_FRAME_KEYFRAME | HW_ENC_FLOAT32:
+        case HW_FRAME_DELTA | HW_ENC_FLOAT32:
+            return HW_RECORD_SIZE_V2;
+        case HW_FRAME_KEYFRAME | HW_ENC_FLOAT16:
+        case HW_FRAME_DELTA | HW_ENC_FLOAT16:
+        case HW_FRAME_KEYFRAME | HW_ENC_INT16:
+        case HW_FRAME_DELTA | HW_ENC_INT16:
+            return HW_RECORD_SIZE_16;
+        case HW_FRAME_SCALE:
+            return HW_RECORD_SIZE_SCALE;
+        case HW_FRAME_SCHEMA:
+            return HW_RECORD_SIZE_ID;
+        case HW_FRAME_META:
+        case HW_FRAME_META | HW_META_RESET:
+            return HW_RECORD_SIZE_META;
+        // Same values as keyframes, without the ID
+        case HW_FRAME_VALUES | HW_ENC_FLOAT32:
+            return HW_RECORD_SIZE_V2 - HW_RECORD_SIZE_ID;
+        case HW_FRAME_VALUES | HW_ENC_FLOAT16:
+        case HW_FRAME_VALUES | HW_ENC_INT16:
+            return HW_RECORD_SIZE_16 - HW_RECORD_SIZE_ID;
+        default:
+            return 0;
+        }
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Get header size for a protocol version
+ * @param version Version byte from frame header
+ * @param type TYPE byte of v3 frames, ignored for v1 and v2
+ * @return Bytes from START through COUNT
+ */
+inline uint8_t hwHeaderSize(uint8_t version, uint8_t type = HW_FRAME_KEYFRAME)
+{
+    if (version != HW_PROTO_VERSION_V3)
+        return HW_HEADER_SIZE;
+    return (type & HW_FRAME_KIND_MASK) == HW_FRAME_VALUES ? HW_HEADER_SIZE_VALUES : HW_HEADER_SIZE_V3;
+}
+
+/**
+ * @brief Get the COUNT limit of a frame
+ * @param version Version byte from frame header
+ * @param type TYPE byte of v3 frames, ignored for v1 and v2
+ * @return Most records the frame may carry, whatever the receiver stores
+ */
+inline uint8_t hwMaxRecords(uint8_t version, uint8_t type = HW_FRAME_KEYFRAME)
+{
+    if (version != HW_PROTO_VERSION_V3)
+        return HW_MAX_RECORDS;
+
+    switch (type & HW_FRAME_KIND_MASK)
+    {
+    case HW_FRAME_SCALE:
+        return HW_SCALE_RECORDS;
+    case HW_FRAME_META:
+        return HW_META_RECORDS;
+    default:
+        return HW_MAX_RECORDS;
+    }
+}
+
+/**
+ * @brief Read a little-endian float32
+ */
+inline float hwReadFloat(const uint8_t *p)
+{
+    union
+    {
+        float f;
+        uint8_t b[4];
+    } converter;
+
+    converter.b[0] = p[0];
+    converter.b[1] = p[1];
+    converter.b[2] = p[2];
+    converter.b[3] = p[3];
+    return converter.f;
+}
+
+/**
+ * @brief Value of an ASCII hex digit
+ * @return 0-15, or 0xFF for any other byte
+ */
+inline uint8_t hwHexDigit(uint8_t c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    c |= 0x20; // lower case
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return 0xFF;
+}
+
+// 1e0 to 1e9, scales a decimal mantissa by its exponent
+extern const float hwPow10[10];
+
+/**
+ * @brief Convert IEEE 754 binary16 to float using integer operations only
+ * @param h Half-precision bits
+ * @return Same value as float (subnormals, infinities and NaN preserved)
+ */
+inline float hwHalfToFloat(uint16_t h)
+{
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    uint32_t exp = (h >> 10) & 0x1F;
+    uint32_t mant = h & 0x3FF;
+
+    union
+    {
+        uint32_t u;
+        float f;
+    } converter;
+
+    if (exp == 0x1F)
+    {
+        converter.u = sign | 0x7F800000UL | (mant << 13);
+    }
+    else if (exp != 0)
+    {
+        converter.u = sign | ((exp + 112) << 23) | (mant << 13);
+    }
+    else if (mant == 0)
+    {
+        converter.u = sign;
+    }
+    else
+    {
+        // Subnormal half, normalize into a regular float
+        exp = 113;
+        while (!(mant & 0x400))
+        {
+            mant <<= 1;
+            exp--;
+        }
+        converter.u = sign | (exp << 23) | ((mant & 0x3FF) << 13);
+    }
+    return converter.f;
+}
+
+// CRC-16/MODBUS (reflected 0xA001), kept in flash.
+// AVR uses a 16-entry nibble table to save flash, others a full byte table.
+#if defined(__AVR__)
+extern const uint16_t hwCrc16Nibble[16] PROGMEM;
+
+/**
+ * @brief Advance CRC-16/MODBUS by one byte
+ */
+inline uint16_t hwCrc16Step(uint16_t crc, uint8_t byte)
+{
+    crc = (crc >> 4) ^ pgm_read_word(&hwCrc16Nibble[(crc ^ byte) & 0x0F]);
+    crc = (crc >> 4) ^ pgm_read_word(&hwCrc16Nibble[(crc ^ (byte >> 4)) & 0x0F]);
+    return crc;
+}
+#else
+extern const uint16_t hwCrc16Table[256] PROGMEM;
+
+/**
+ * @brief Advance CRC-16/MODBUS by one byte
+ */
+inline uint16_t hwCrc16Step(uint16_t crc, uint8_t byte)
+{
+    return (crc >> 8) ^ pgm_read_word(&hwCrc16Table[(crc ^ byte) & 0xFF]);
+}
+#endif
+
+/**
+ * @brief Compute CRC-16/MODBUS
+ * @param data Pointer to data
+ * @param len Length of data
+ * @param crc Running CRC (pass a previous result to continue)
+ * @return Updated CRC
+ */
+inline uint16_t hwCrc16(const uint8_t *data, size_t len, uint16_t crc = HW_CRC_INIT)
+{
+    while (len--)
+    {
+        crc = hwCrc16Step(crc, *data++);
+    }
+    return crc;
+}
+
+/**
+ * @brief Get the worst case COBS-encoded size
+ * @param len Length of data to encode
+ * @return Encoded bytes, excluding the 0x00 delimiter
+ */
+inline size_t hwCobsMaxSize(size_t len)
+{
+    return len + len / 254 + 1;
+}
+
+/**
+ * @brief COBS-encode a buffer in one pass
+ * @param src Data to encode, may contain 0x00
+ * @param len Length of data
+ * @param dst Output, at least hwCobsMaxSize(len) bytes, must not overlap src
+ * @return Encoded length; the caller appends HW_COBS_DELIMITER
+ */
+size_t hwCobsEncode(const uint8_t *src, size_t len, uint8_t *dst);
+
+/**
+ * @brief COBS-decode one frame in one pass
+ * @param src Encoded bytes without the delimiter
+ * @param len Length of encoded data
+ * @param dst Output, at least len bytes, may equal src
+ * @return Decoded length, or HW_COBS_ERROR if src is malformed
+ */
+size_t hwCobsDecode(const uint8_t *src, size_t len, uint8_t *dst);
+
 /**
  * @brief Get sensor name string
  * @param id Sensor ID
  * @return Human-readable sensor name
  */
-const char *hwGetSensorName(uint8_t id);
+const char *hwGetSensorName(HWSensorId id);
 
 /**
  * @brief Get sensor unit string
  * @param id Sensor ID
  * @return Unit string (°C, %, MHz, etc.)
  */
-const char *hwGetSensorUnit(uint8_t id);
+const char *hwGetSensorUnit(HWSensorId id);
 
 /**
  * @brief Get sensor category
  * @param id Sensor ID
  * @return Category string (CPU, GPU, RAM, etc.)
  */
-const char *hwGetSensorCategory(uint8_t id);
+const char *hwGetSensorCategory(HWSensorId id);
+
+// Template member definitions
+#include "HWMonitorImpl.h"
 
-#endif // HW_MONITOR_H
\ No newline at end of file
+#endif // HW_MONITOR_H
@@ -0,0 +1,2195 @@
+/**
+ * @file HWMonitorImpl.h
+ * @brief HWMonitorT member definitions, included from HWMonitor.h
+ */
+
+#ifndef HW_MONITOR_IMPL_H
+#define HW_MONITOR_IMPL_H
+
+#define HW_TEMPLATE template <uint8_t MaxSensors, typename IdType, uint16_t Features>
+#define HW_MONITOR HWMonitorT<MaxSensors, IdType, Features>
+
+/*===========================================================================*/
+/*  CONSTRUCTOR & INITIALIZATION                                             */
+/*===========================================================================*/
+
+HW_TEMPLATE
+HW_MONITOR::HWMonitorT()
+    : packetsOK(0), packetsError(0), crcErrors(0), deltasMissed(0), scaleMisses(0), schemaMisses(0), sensorCount(0), lastUpdate(0), resync(), _front(0), _seq(0), _indexStale(false), _scaleCount(0), _schemaSize(0), _schemaCount(0), _schemaHash(0), _schemaCrc(HW_CRC_INIT), _schemaValid(false), _schemaDense(true), _schemaMiss(false), _metaCount(0), _metaArenaLen(0), _metaValid(false), _framing(HW_FRAMING_RAW), _state(HW_STATE_IDLE), _version(0), _frameVersion(0), _frameType(HW_FRAME_KEYFRAME), _encoding(HW_ENC_FLOAT32), _frameSeq(0), _frameHash(0), _lastSeq(0), _seqValid(false), _needKeyframe(true), _recordSize(0), _expectedCount(0), _currentSensor(0), _storedCount(0), _byteInRecord(0), _crcLow(0), _crcReceived(0), _crc(HW_CRC_INIT), _rxLen(0), _rxOverflow(false), _resyncPending(false), _resyncBytes(0), _resyncFrames(0), _textState(HW_STATE_TEXT_IDLE), _textSum(0), _textCheck(0), _textLine(0), _textDigits(0), _textExp(0), _textFlags(0), _textId(0), _textMant(0), _flowWindow(0), _flowErrors(0), _subCount(0), _subActive(false), _subPending(false), _subTime(0), _bandCount(0), _bandsDirty(true)
+{
+}
+
+HW_TEMPLATE
+void HW_MONITOR::begin()
+{
+    reset();
+}
+
+HW_TEMPLATE
+void HW_MONITOR::reset()
+{
+    for (uint8_t b = 0; b < 2; b++)
+    {
+        for (uint8_t i = 0; i < MaxSensors; i++)
+        {
+            _ids[b][i] = (IdType)SENSOR_UNKNOWN;
+            _values[b][i] = -999.0f;
+        }
+        memset(_valid[b], 0, VALID_BYTES);
+        memset(_stamps[b], 0, sizeof(_stamps[b]));
+        _bankCount[b] = 0;
+        _bankTime[b] = 0;
+    }
+
+    _front = 0;
+    _seq = 0;
+    _index[0].clear();
+    _index[1].clear();
+    _indexStale = false;
+    _scaleCount = 0;
+    _scaleIndex.clear();
+    _schemaValid = false;
+    _clearMeta();
+    _state = HW_STATE_IDLE;
+    _textState = HW_STATE_TEXT_IDLE;
+    _seqValid = false;
+    _needKeyframe = true;
+    _rxLen = 0;
+    _rxOverflow = false;
+    _resyncPending = false;
+    sensorCount = 0;
+    packetsOK = 0;
+    packetsError = 0;
+    crcErrors = 0;
+    deltasMissed = 0;
+    scaleMisses = 0;
+    schemaMisses = 0;
+    lastUpdate = 0;
+    _flowErrors = 0;
+    _subPending = _subActive;
+    _bandsDirty = true;
+    memset(_moved, 0, VALID_BYTES);
+    memset(_changed, 0, VALID_BYTES);
+    memset(&resync, 0, sizeof(resync));
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::setFraming(HWFraming framing)
+{
+    if ((framing == HW_FRAMING_COBS && !HAS_COBS) || (framing == HW_FRAMING_TEXT && !HAS_TEXT))
+        return false;
+
+    // Drop any partial frame, it was collected under the other framing
+    _framing = framing;
+    _state = HW_STATE_IDLE;
+    _textState = HW_STATE_TEXT_IDLE;
+    _rxLen = 0;
+    _rxOverflow = false;
+    return true;
+}
+
+/*===========================================================================*/
+/*  STREAM UPDATE                                                            */
+/*===========================================================================*/
+
+HW_TEMPLATE
+bool HW_MONITOR::update(Stream &stream)
+{
+    return poll(stream, 0);
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::poll(Stream &stream, uint32_t budgetUs)
+{
+    bool packetReceived = false;
+    uint8_t chunk[HW_READ_CHUNK_SIZE];
+    uint32_t start = budgetUs ? micros() : 0;
+    int avail;
+
+    while ((avail = stream.available()) > 0)
+    {
+        size_t want = (size_t)avail < sizeof(chunk) ? (size_t)avail : sizeof(chunk);
+        size_t got = stream.readBytes(chunk, want);
+
+        if (got == 0)
+            break;
+
+        if (feed(chunk, got))
+        {
+            packetReceived = true;
+        }
+
+        if (budgetUs && micros() - start >= budgetUs)
+            break;
+    }
+
+    // One status per drain, only once v3 frames carry a SEQ to acknowledge
+    if (_flowWindow && _seqValid && (packetReceived || packetsError != _flowErrors))
+    {
+        uint8_t status[HW_STATUS_MAX_SIZE];
+        stream.write(status, statusFrame(status));
+        _flowErrors = packetsError;
+    }
+
+    // Only while the host is sending, a USB CDC write may block otherwise
+    if (_subActive && packetReceived)
+    {
+        uint32_t now = millis();
+        if (_subPending || now - _subTime >= HW_SUBSCRIBE_INTERVAL_MS)
+        {
+            uint8_t frame[SUBSCRIBE_MAX_SIZE];
+            stream.write(frame, subscriptionFrame(frame));
+            _subTime = now;
+            _subPending = false;
+            _subActive = _subCount > 0;
+        }
+    }
+
+    return packetReceived;
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::drain(hw_ring_t &ring, size_t maxBytes)
+{
+    bool packetReceived = false;
+
+    // At most two runs, the waiting bytes wrap once
+    for (uint8_t pass = 0; pass < 2 && maxBytes > 0; pass++)
+    {
+        const uint8_t *data;
+        size_t len = hw_ring_peek(&ring, &data);
+        if (len == 0)
+            break;
+        if (len > maxBytes)
+            len = maxBytes;
+
+        if (feed(data, len))
+        {
+            packetReceived = true;
+        }
+        hw_ring_skip(&ring, len);
+        maxBytes -= len;
+    }
+
+    return packetReceived;
+}
+
+HW_TEMPLATE
+void HW_MONITOR::enableFlowControl(uint8_t window)
+{
+    _flowWindow = window;
+    _flowErrors = packetsError;
+}
+
+HW_TEMPLATE
+size_t HW_MONITOR::statusFrame(uint8_t *out) const
+{
+    uint8_t frame[HW_STATUS_SIZE];
+
+    frame[0] = HW_PROTO_START;
+    frame[1] = HW_PROTO_VERSION_V3;
+    frame[2] = _needKeyframe ? HW_FRAME_NACK : HW_FRAME_ACK;
+    if (HAS_META && !_metaValid)
+    {
+        frame[2] |= HW_STATUS_WANT_META;
+    }
+    frame[3] = _lastSeq;
+    frame[4] = _flowWindow ? _flowWindow : 0xFF;
+
+    uint16_t crc = hwCrc16(frame + 1, 4);
+    frame[5] = crc & 0xFF;
+    frame[6] = crc >> 8;
+    frame[7] = HW_PROTO_END;
+
+    if (_framing == HW_FRAMING_COBS)
+    {
+        size_t len = hwCobsEncode(frame, HW_STATUS_SIZE, out);
+        out[len++] = HW_COBS_DELIMITER;
+        return len;
+    }
+
+    memcpy(out, frame, HW_STATUS_SIZE);
+    return HW_STATUS_SIZE;
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::subscribe(const IdType *ids, uint8_t count)
+{
+    if (count > HW_MAX_SUBSCRIBE || (count && !ids))
+        return false;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        _subIds[i] = ids[i];
+    }
+
+    _subCount = count;
+    _subActive = true;
+    _subPending = true;
+    return true;
+}
+
+HW_TEMPLATE
+size_t HW_MONITOR::subscriptionFrame(uint8_t *out) const
+{
+    uint8_t frame[SUBSCRIBE_FRAME_SIZE];
+    size_t len = 0;
+
+    frame[len++] = HW_PROTO_START;
+    frame[len++] = HW_PROTO_VERSION_V3;
+    frame[len++] = HW_FRAME_SUBSCRIBE;
+    frame[len++] = 0;
+    frame[len++] = _subCount;
+
+    for (uint8_t i = 0; i < _subCount; i++)
+    {
+        HWSensorId id = (HWSensorId)_subIds[i];
+        frame[len++] = id >> 8;
+        frame[len++] = id & 0xFF;
+    }
+
+    uint16_t crc = hwCrc16(frame + 1, len - 1);
+    frame[len++] = crc & 0xFF;
+    frame[len++] = crc >> 8;
+    frame[len++] = HW_PROTO_END;
+
+    if (_framing == HW_FRAMING_COBS)
+    {
+        size_t encoded = hwCobsEncode(frame, len, out);
+        out[encoded++] = HW_COBS_DELIMITER;
+        return encoded;
+    }
+
+    memcpy(out, frame, len);
+    return len;
+}
+
+/*===========================================================================*/
+/*  CHUNK PARSER                                                             */
+/*===========================================================================*/
+
+HW_TEMPLATE
+bool HW_MONITOR::feed(const uint8_t *data, size_t len)
+{
+    bool packetReceived = false;
+    const uint8_t *p = data;
+    const uint8_t *end = data + len;
+
+    if (HAS_TEXT && _framing == HW_FRAMING_TEXT)
+    {
+        return _feedText(data, len);
+    }
+
+    if (_framing == HW_FRAMING_COBS)
+    {
+        // Collect everything up to a delimiter in one copy
+        while (p < end)
+        {
+            const uint8_t *delim = (const uint8_t *)memchr(p, HW_COBS_DELIMITER, end - p);
+            _capture(p, (delim ? delim : end) - p);
+            if (!delim)
+                break;
+
+            if (_cobsFrame(_rxOverflow ? nullptr : _rxBuffer, _rxLen))
+            {
+                packetReceived = true;
+            }
+            _rxLen = 0;
+            _rxOverflow = false;
+            p = delim + 1;
+        }
+
+        return packetReceived;
+    }
+
+    while (p < end)
+    {
+        if (_state == HW_STATE_IDLE)
+        {
+            // Skip garbage up to the next START byte in one call
+            const uint8_t *start = (const uint8_t *)memchr(p, HW_PROTO_START, end - p);
+            if (!start)
+            {
+                _countDiscarded(end - p);
+                break;
+            }
+
+            _countDiscarded(start - p);
+            p = start;
+
+            if (processByte(*p++))
+            {
+                packetReceived = true;
+            }
+        }
+        else if (_state == HW_STATE_DATA && _byteInRecord == 0)
+        {
+            // Decode complete records straight from the chunk
+            size_t n = (end - p) / _recordSize;
+            if (n > (size_t)(_expectedCount - _currentSensor))
+                n = _expectedCount - _currentSensor;
+
+            size_t bytes = n * _recordSize;
+            if (HAS_CRC)
+            {
+                _crc = hwCrc16(p, bytes, _crc);
+            }
+            _capture(p, bytes);
+
+            if (_frameType == HW_FRAME_VALUES)
+            {
+                _decodeValues(p, n);
+                _currentSensor += n;
+                p += bytes;
+            }
+            else
+            {
+                while (n--)
+                {
+                    _decodeRecord(_version, p);
+                    _currentSensor++;
+                    p += _recordSize;
+                }
+            }
+
+            if (_currentSensor >= _expectedCount)
+            {
+                _state = HW_STATE_CRC_LOW;
+            }
+            else
+            {
+                // Record split across chunks: buffer the head byte-wise
+                while (p < end)
+                {
+                    processByte(*p++);
+                }
+            }
+        }
+        else if (processByte(*p++))
+        {
+            packetReceived = true;
+        }
+    }
+
+    return packetReceived;
+}
+
+/*===========================================================================*/
+/*  BYTE-BY-BYTE PARSER                                                      */
+/*===========================================================================*/
+
+HW_TEMPLATE
+bool HW_MONITOR::processByte(uint8_t byte)
+{
+    if (HAS_TEXT && _framing == HW_FRAMING_TEXT)
+    {
+        return _stepText(byte);
+    }
+
+    if (_framing == HW_FRAMING_COBS)
+    {
+        if (byte != HW_COBS_DELIMITER)
+        {
+            _capture(&byte, 1);
+            return false;
+        }
+
+        bool packetReceived = _cobsFrame(_rxOverflow ? nullptr : _rxBuffer, _rxLen);
+        _rxLen = 0;
+        _rxOverflow = false;
+        return packetReceived;
+    }
+
+    if (_state == HW_STATE_IDLE)
+    {
+        if (byte != HW_PROTO_START)
+        {
+            _countDiscarded(1);
+            return false;
+        }
+
+        _rxLen = 0;
+        _rxOverflow = false;
+    }
+
+    _capture(&byte, 1);
+
+    switch (_step(byte))
+    {
+    case STEP_FRAME:
+        return true;
+    case STEP_ERROR:
+        return _resync();
+    default:
+        return false;
+    }
+}
+
+HW_TEMPLATE
+typename HW_MONITOR::StepResult HW_MONITOR::_step(uint8_t byte)
+{
+    switch (_state)
+    {
+    case HW_STATE_IDLE:
+        if (byte == HW_PROTO_START)
+        {
+            _state = HW_STATE_VERSION;
+        }
+        break;
+
+    case HW_STATE_VERSION:
+        _recordSize = hwRecordSize(byte);
+
+        if (_recordSize)
+        {
+            _version = byte;
+            _frameType = HW_FRAME_KEYFRAME;
+            _encoding = HW_ENC_FLOAT32;
+            _crc = HAS_CRC ? hwCrc16Step(HW_CRC_INIT, byte) : HW_CRC_INIT;
+            _state = byte == HW_PROTO_VERSION_V3 ? HW_STATE_TYPE : HW_STATE_COUNT;
+        }
+        else
+        {
+            packetsError++;
+            return STEP_ERROR;
+        }
+        break;
+
+    case HW_STATE_TYPE:
+        _recordSize = hwRecordSize(_version, byte);
+
+        if (!_recordSize)
+        {
+            packetsError++;
+            return STEP_ERROR;
+        }
+
+        _frameType = byte & HW_FRAME_KIND_MASK;
+        _encoding = byte & HW_ENC_MASK;
+        if (HAS_CRC)
+        {
+            _crc = hwCrc16Step(_crc, byte);
+        }
+        _state = HW_STATE_SEQ;
+        break;
+
+    case HW_STATE_SEQ:
+        _frameSeq = byte;
+        if (HAS_CRC)
+        {
+            _crc = hwCrc16Step(_crc, byte);
+        }
+        _state = _frameType == HW_FRAME_VALUES ? HW_STATE_HASH_LOW : HW_STATE_COUNT;
+        break;
+
+    case HW_STATE_HASH_LOW:
+        _frameHash = byte;
+        if (HAS_CRC)
+        {
+            _crc = hwCrc16Step(_crc, byte);
+        }
+        _state = HW_STATE_HASH_HIGH;
+        break;
+
+    case HW_STATE_HASH_HIGH:
+        _frameHash |= (uint16_t)byte << 8;
+        if (HAS_CRC)
+        {
+            _crc = hwCrc16Step(_crc, byte);
+        }
+        _state = HW_STATE_COUNT;
+        break;
+
+    case HW_STATE_COUNT:
+        if (HAS_CRC)
+        {
+            _crc = hwCrc16Step(_crc, byte);
+        }
+
+        // Empty v3 frames are valid, a delta with nothing changed
+        if (byte > hwMaxRecords(_version, _frameType) ||
+            (byte == 0 && _version != HW_PROTO_VERSION_V3))
+        {
+            packetsError++;
+            return STEP_ERROR;
+        }
+
+        _expectedCount = byte;
+        _beginFrame(_version);
+        _state = byte ? HW_STATE_DATA : HW_STATE_CRC_LOW;
+        break;
+
+    case HW_STATE_DATA:
+        _record[_byteInRecord++] = byte;
+
+        if (HAS_CRC)
+        {
+            _crc = hwCrc16Step(_crc, byte);
+        }
+
+        if (_byteInRecord == _recordSize)
+        {
+            _decodeRecord(_version, _record);
+            _currentSensor++;
+            _byteInRecord = 0;
+
+            if (_currentSensor >= _expectedCount)
+            {
+                _state = HW_STATE_CRC_LOW;
+            }
+        }
+        break;
+
+    case HW_STATE_CRC_LOW:
+        _crcLow = byte;
+        _state = HW_STATE_CRC_HIGH;
+        break;
+
+    case HW_STATE_CRC_HIGH:
+        _crcReceived = _crcLow | ((uint16_t)byte << 8);
+        _state = HW_STATE_END;
+        break;
+
+    case HW_STATE_END:
+        _state = HW_STATE_IDLE;
+
+        if (byte != HW_PROTO_END)
+        {
+            packetsError++;
+            return STEP_ERROR;
+        }
+
+        if (HAS_CRC && _crcReceived != _crc)
+        {
+            crcErrors++;
+            packetsError++;
+            return STEP_ERROR;
+        }
+
+        return _commitFrame(HAS_RESYNC && !_rxOverflow ? _rxBuffer : nullptr) ? STEP_FRAME : STEP_CONTINUE;
+    }
+
+    return STEP_CONTINUE;
+}
+
+HW_TEMPLATE
+void HW_MONITOR::_beginFrame(uint8_t version)
+{
+    uint8_t front = _front;
+    uint8_t back = front ^ 1;
+
+    _frameVersion = version;
+    _currentSensor = 0;
+    _byteInRecord = 0;
+    memset(_updated, 0, VALID_BYTES);
+
+    if (_frameType == HW_FRAME_DELTA)
+    {
+        // Deltas patch a private copy of the published state
+        uint8_t count = _bankCount[front];
+        memcpy(_ids[back], _ids[front], count * sizeof(IdType));
+        memcpy(_values[back], _values[front], count * sizeof(float));
+        memcpy(_valid[back], _valid[front], VALID_BYTES);
+        if (HAS_TIMESTAMPS)
+        {
+            memcpy(_stamps[back], _stamps[front], count * sizeof(uint32_t));
+        }
+        _storedCount = count;
+    }
+    else
+    {
+        memset(_valid[back], 0, VALID_BYTES);
+        _storedCount = 0;
+    }
+
+    if (_frameType == HW_FRAME_SCHEMA)
+    {
+        _schemaCrc = HW_CRC_INIT;
+        memset(_schemaNext, 0, SCHEMA_KEEP_BYTES);
+    }
+    else if (_frameType == HW_FRAME_VALUES)
+    {
+        _schemaMiss = !HAS_SCHEMA || !_schemaValid || _frameHash != _schemaHash || _expectedCount != _schemaSize;
+
+        // Slots are schema positions, so the whole layout is one copy
+        if (!_schemaMiss && _schemaDense)
+        {
+            memcpy(_ids[back], _schemaIds, _schemaCount * sizeof(IdType));
+        }
+    }
+}
+
+HW_TEMPLATE
+void HW_MONITOR::_decodeRecord(uint8_t version, const uint8_t *record)
+{
+    // Applied as a whole once the CRC has been checked
+    if (_frameType == HW_FRAME_SCALE || _frameType == HW_FRAME_META)
+        return;
+
+    if (_frameType == HW_FRAME_VALUES)
+    {
+        _decodeValues(record, 1);
+        return;
+    }
+
+    uint8_t back = _front ^ 1;
+
+    if (_frameType == HW_FRAME_SCHEMA)
+    {
+        if (!HAS_SCHEMA)
+            return;
+
+        // Staged in the back bank; _schemaNext marks the kept positions
+        HWSensorId id = ((HWSensorId)record[0] << 8) | record[1];
+        _schemaCrc = hwCrc16(record, HW_RECORD_SIZE_ID, _schemaCrc);
+        if ((IdType)id == id && _storedCount < SCHEMA_CAPACITY)
+        {
+            _ids[back][_storedCount++] = (IdType)id;
+            if (SCHEMA_NARROW)
+                _schemaNext[_currentSensor >> 3] |= 1 << (_currentSensor & 7);
+        }
+        return;
+    }
+
+    // v1: [ID][VALUE], v2/v3: [ID_HI][ID_LO][VALUE]
+    HWSensorId id;
+    if (version == HW_PROTO_VERSION_V1)
+    {
+        id = record[0];
+        record += 1;
+    }
+    else
+    {
+        id = ((HWSensorId)record[0] << 8) | record[1];
+        record += 2;
+    }
+
+    // Narrow instances skip IDs they cannot store
+    if ((IdType)id != id)
+        return;
+
+    float value;
+    if (_decodeValue((IdType)id, record, value))
+    {
+        _store((IdType)id, value);
+    }
+}
+
+HW_TEMPLATE
+void HW_MONITOR::_store(IdType id, float value)
+{
+    uint8_t back = _front ^ 1;
+
+    // Back bank stays private until the frame is validated
+    uint8_t slot = HW_INDEX_EMPTY;
+
+    if (_frameType == HW_FRAME_DELTA)
+    {
+        // Index matches the copied layout; IDs appended by this delta are scanned
+        uint8_t known = _bankCount[_front];
+        slot = _index[_front].find((IdType)id, _ids[back]);
+        if (slot >= known)
+        {
+            slot = HW_INDEX_EMPTY;
+            for (uint8_t i = known; i < _storedCount; i++)
+            {
+                if (_ids[back][i] == (IdType)id)
+                {
+                    slot = i;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (slot == HW_INDEX_EMPTY)
+    {
+        if (_storedCount >= MaxSensors)
+            return;
+
+        slot = _storedCount++;
+        _ids[back][slot] = (IdType)id;
+    }
+
+    _values[back][slot] = value;
+    _updated[slot >> 3] |= 1 << (slot & 7);
+}
+
+HW_TEMPLATE
+void HW_MONITOR::_decodeValues(const uint8_t *data, uint8_t count)
+{
+    if (!HAS_SCHEMA || _schemaMiss)
+        return;
+
+    uint8_t back = _front ^ 1;
+    uint8_t size = _encoding == HW_ENC_FLOAT32 ? sizeof(float) : sizeof(int16_t);
+
+    if (_schemaDense)
+    {
+        uint8_t first = _currentSensor;
+
+        if (_encoding == HW_ENC_FLOAT32)
+        {
+            // Wire values are little-endian like every supported MCU
+            memcpy(&_values[back][first], data, count * sizeof(float));
+        }
+
+        for (uint8_t i = 0; i < count; i++)
+        {
+            uint8_t slot = first + i;
+            if (_encoding == HW_ENC_FLOAT32 || _decodeValue(_schemaIds[slot], data + i * size, _values[back][slot]))
+            {
+                _updated[slot >> 3] |= 1 << (slot & 7);
+            }
+        }
+
+        _storedCount = first + count;
+        return;
+    }
+
+    // Positions whose ID this instance cannot store are skipped
+    for (uint8_t i = 0; i < count; i++, data += size)
+    {
+        if (!_schemaKept(_currentSensor + i))
+            continue;
+
+        uint8_t slot = _storedCount++;
+        _ids[back][slot] = _schemaIds[slot];
+        if (_decodeValue(_schemaIds[slot], data, _values[back][slot]))
+        {
+            _updated[slot >> 3] |= 1 << (slot & 7);
+        }
+    }
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::_schemaKept(uint8_t position) const
+{
+    // Wide IDs all fit, so the kept positions are the first _schemaCount
+    if (!SCHEMA_NARROW)
+        return position < _schemaCount;
+    return hwBitTest(_schemaKeep, position);
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::_decodeValue(IdType id, const uint8_t *data, float &value)
+{
+    switch (_encoding)
+    {
+    case HW_ENC_FLOAT16:
+        value = hwHalfToFloat(data[0] | ((uint16_t)data[1] << 8));
+        return true;
+
+    case HW_ENC_INT16:
+    {
+        uint8_t s = HAS_SCALED ? _scaleIndex.find(id, _scaleIds) : HW_INDEX_EMPTY;
+        if (s >= _scaleCount)
+        {
+            scaleMisses++;
+            return false;
+        }
+        value = (int16_t)(data[0] | ((uint16_t)data[1] << 8)) * _scaleMul[s] + _scaleAdd[s];
+        return true;
+    }
+
+    default:
+        value = hwReadFloat(data);
+        return true;
+    }
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::_commitFrame(const uint8_t *frame)
+{
+    if (_frameType == HW_FRAME_SCALE)
+    {
+        if (!_applyScales(frame))
+        {
+            packetsError++;
+            return false;
+        }
+
+        _trackSequence();
+        packetsOK++;
+        return true;
+    }
+
+    if (_frameType == HW_FRAME_META)
+    {
+        // Roles are rebound in place, so readers that resolved one retry
+        bool rebind = HAS_META && frame;
+        if (rebind)
+        {
+            _seq = _seq + 1;
+            HW_BARRIER();
+        }
+
+        bool applied = _applyMeta(frame);
+
+        if (rebind)
+        {
+            HW_BARRIER();
+            _seq = _seq + 1;
+        }
+
+        if (!applied)
+        {
+            packetsError++;
+            return false;
+        }
+
+        _trackSequence();
+        packetsOK++;
+        return true;
+    }
+
+    if (_frameType == HW_FRAME_SCHEMA)
+    {
+        if (HAS_SCHEMA)
+        {
+            uint8_t back = _front ^ 1;
+            memcpy(_schemaIds, _ids[back], _storedCount * sizeof(IdType));
+            memcpy(_schemaKeep, _schemaNext, SCHEMA_KEEP_BYTES);
+            _schemaSize = _expectedCount;
+            _schemaCount = _storedCount;
+            _schemaDense = _storedCount == _expectedCount;
+            _schemaHash = _schemaCrc;
+            _schemaValid = true;
+        }
+
+        _trackSequence();
+        packetsOK++;
+        return true;
+    }
+
+    if (_frameType == HW_FRAME_VALUES && _schemaMiss)
+    {
+        // Values for a schema we do not have, there is no way to place them
+        schemaMisses++;
+        _trackSequence();
+        _needKeyframe = true;
+        return false;
+    }
+
+    uint8_t count = _storedCount;
+    uint32_t now = millis();
+    uint8_t back = _front ^ 1;
+
+    for (uint8_t i = 0; i < VALID_BYTES; i++)
+    {
+        _valid[back][i] |= _updated[i];
+    }
+
+    if (HAS_TIMESTAMPS)
+    {
+        for (uint8_t i = 0; i < count; i++)
+        {
+            if (hwBitTest(_updated, i))
+                _stamps[back][i] = now;
+        }
+    }
+
+    bool relayout = count != _bankCount[_front] || memcmp(_ids[back], _ids[_front], count * sizeof(IdType)) != 0;
+    if (relayout)
+    {
+        _index[back].build(_ids[back], count);
+        _indexStale = true;
+    }
+    else if (_indexStale)
+    {
+        _index[back] = _index[_front];
+        _indexStale = false;
+    }
+
+    _detectChanges(count, relayout);
+
+    // Older change bits point at slots of the previous layout
+    for (uint8_t i = 0; i < VALID_BYTES; i++)
+    {
+        _changed[i] = relayout ? 0xFF : _changed[i] | _moved[i];
+    }
+
+    _trackSequence();
+    _publish(count, now);
+    packetsOK++;
+
+    if (_resyncPending)
+    {
+        _resyncPending = false;
+        resync.lastBytes = _resyncBytes;
+        resync.lastFrames = _resyncFrames;
+        if (_resyncBytes > resync.maxBytes)
+            resync.maxBytes = _resyncBytes;
+        if (_resyncFrames > resync.maxFrames)
+            resync.maxFrames = _resyncFrames;
+    }
+
+    // Call sensor callback if set
+    if (HAS_CALLBACKS && _callbacks.sensor)
+    {
+        for (uint8_t i = 0; i < count; i++)
+        {
+            if (hwBitTest(_updated, i))
+                _callbacks.sensor(_ids[back][i], _values[back][i]);
+        }
+    }
+
+    if (HAS_CALLBACKS && _callbacks.change)
+    {
+        _frameView(_moved).forEachChanged(_callbacks.change);
+    }
+
+    if (HAS_CALLBACKS && _callbacks.frame)
+    {
+        _callbacks.frame(_frameView(_moved));
+    }
+
+    // Call packet callback if set
+    if (HAS_CALLBACKS && _callbacks.packet)
+    {
+        _callbacks.packet(sensorCount);
+    }
+
+    return true;
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::_applyScales(const uint8_t *frame)
+{
+    if (!HAS_SCALED)
+        return true; // int16 values will count as scaleMisses
+
+    // Streamed frames are read back from the lookback buffer
+    if (!frame)
+        return false;
+
+    uint8_t count = frame[HW_HEADER_SIZE_V3 - 1];
+    const uint8_t *record = frame + HW_HEADER_SIZE_V3;
+    uint8_t known = _scaleCount;
+
+    for (uint8_t i = 0; i < count; i++, record += HW_RECORD_SIZE_SCALE)
+    {
+        HWSensorId id = ((HWSensorId)record[0] << 8) | record[1];
+        if ((IdType)id != id)
+            continue;
+
+        uint8_t s = _scaleIndex.find((IdType)id, _scaleIds);
+        if (s >= known)
+        {
+            s = HW_INDEX_EMPTY;
+            for (uint8_t j = known; j < _scaleCount; j++)
+            {
+                if (_scaleIds[j] == (IdType)id)
+                {
+                    s = j;
+                    break;
+                }
+            }
+        }
+
+        if (s == HW_INDEX_EMPTY)
+        {
+            if (_scaleCount >= SCALE_CAPACITY)
+                continue;
+
+            s = _scaleCount++;
+            _scaleIds[s] = (IdType)id;
+        }
+
+        _scaleMul[s] = hwReadFloat(record + 2);
+        _scaleAdd[s] = hwReadFloat(record + 6);
+    }
+
+    if (_scaleCount != known)
+    {
+        _scaleIndex.build(_scaleIds, _scaleCount);
+    }
+
+    return true;
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::_applyMeta(const uint8_t *frame)
+{
+    if (!HAS_META)
+        return true;
+
+    // Streamed frames are read back from the lookback buffer
+    if (!frame)
+        return false;
+
+    // The first frame of a set replaces everything described before
+    if (frame[2] & HW_META_RESET)
+    {
+        _clearMeta();
+    }
+    _metaValid = true;
+
+    uint8_t count = frame[HW_HEADER_SIZE_V3 - 1];
+    const uint8_t *record = frame + HW_HEADER_SIZE_V3;
+    uint8_t known = _metaCount;
+
+    for (uint8_t i = 0; i < count; i++, record += HW_RECORD_SIZE_META)
+    {
+        HWSensorId id = ((HWSensorId)record[0] << 8) | record[1];
+        uint8_t role = record[2];
+
+        if (role && role < HW_ROLE_COUNT)
+        {
+            _roleIds[role] = id;
+        }
+
+        if ((IdType)id != id)
+            continue;
+
+        uint8_t m = _metaIndex.find((IdType)id, _metaIds);
+        if (m >= known)
+        {
+            m = HW_INDEX_EMPTY;
+            for (uint8_t j = known; j < _metaCount; j++)
+            {
+                if (_metaIds[j] == (IdType)id)
+                {
+                    m = j;
+                    break;
+                }
+            }
+        }
+
+        if (m == HW_INDEX_EMPTY)
+        {
+            if (_metaCount >= META_CAPACITY)
+                continue;
+
+            m = _metaCount++;
+            _metaIds[m] = (IdType)id;
+        }
+
+        _metaUnit[m] = _intern(record + 3, HW_META_UNIT_SIZE);
+        _metaName[m] = _intern(record + 3 + HW_META_UNIT_SIZE, HW_META_NAME_SIZE);
+    }
+
+    if (_metaCount != known)
+    {
+        _metaIndex.build(_metaIds, _metaCount);
+    }
+
+    // Category deadbands follow the roles
+    _bandsDirty = true;
+    return true;
+}
+
+HW_TEMPLATE
+uint16_t HW_MONITOR::_intern(const uint8_t *text, uint8_t size)
+{
+    uint8_t len = 0;
+    while (len < size && text[len])
+    {
+        len++;
+    }
+
+    // Units and many names repeat, reuse an equal string already stored
+    uint16_t pos = 0;
+    while (pos < _metaArenaLen)
+    {
+        uint16_t stored = strlen(_metaArena + pos);
+        if (stored == len && memcmp(_metaArena + pos, text, len) == 0)
+            return pos;
+        pos += stored + 1;
+    }
+
+    if (_metaArenaLen + len + 1 > META_ARENA)
+        return META_NONE;
+
+    memcpy(_metaArena + pos, text, len);
+    _metaArena[pos + len] = '\0';
+    _metaArenaLen += len + 1;
+    return pos;
+}
+
+HW_TEMPLATE
+void HW_MONITOR::_clearMeta()
+{
+    for (uint8_t r = 0; r < ROLE_CAPACITY; r++)
+    {
+        _roleIds[r] = SENSOR_UNKNOWN;
+    }
+
+    _metaCount = 0;
+    _metaIndex.clear();
+    _metaArenaLen = 0;
+    _metaValid = false;
+}
+
+HW_TEMPLATE
+void HW_MONITOR::_trackSequence()
+{
+    if (_frameVersion == HW_PROTO_VERSION_V3)
+    {
+        uint8_t gap = _frameSeq - (uint8_t)(_lastSeq + 1);
+
+        if (_frameType == HW_FRAME_DELTA && _seqValid && gap)
+        {
+            deltasMissed += gap;
+            _needKeyframe = true;
+        }
+
+        _lastSeq = _frameSeq;
+        _seqValid = true;
+    }
+
+    if (_frameType == HW_FRAME_KEYFRAME || _frameType == HW_FRAME_VALUES)
+    {
+        _needKeyframe = false;
+    }
+}
+
+HW_TEMPLATE
+void HW_MONITOR::_publish(uint8_t count, uint32_t now)
+{
+    uint8_t back = _front ^ 1;
+
+    _bankCount[back] = count;
+    _bankTime[back] = now;
+
+    // Seqlock: odd while the front bank is being switched
+    _seq = _seq + 1;
+    HW_BARRIER();
+    _front = back;
+    HW_BARRIER();
+    _seq = _seq + 1;
+
+    sensorCount = count;
+    lastUpdate = now;
+}
+
+/*===========================================================================*/
+/*  TEXT FRAMING                                                             */
+/*===========================================================================*/
+
+HW_TEMPLATE
+bool HW_MONITOR::_feedText(const uint8_t *data, size_t len)
+{
+    bool packetReceived = false;
+    const uint8_t *p = data;
+    const uint8_t *end = data + len;
+
+    while (p < end)
+    {
+        if (_textState == HW_STATE_TEXT_IDLE)
+        {
+            // Jump straight to the next '$', nothing before it can start a frame
+            const uint8_t *mark = (const uint8_t *)memchr(p, HW_TEXT_MARK, end - p);
+            if (!mark)
+            {
+                _countDiscarded(end - p);
+                break;
+            }
+            _countDiscarded(mark - p);
+            p = mark;
+        }
+
+        if (_stepText(*p++))
+        {
+            packetReceived = true;
+        }
+    }
+
+    return packetReceived;
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::_stepText(uint8_t byte)
+{
+    if (_textState == HW_STATE_TEXT_IDLE)
+    {
+        if (byte != HW_TEXT_MARK)
+        {
+            _countDiscarded(1);
+            return false;
+        }
+        _textState = HW_STATE_TEXT_START;
+        _textSum = byte;
+        _textLine = 1;
+        return false;
+    }
+
+    // Lines are bounded, so garbage without newlines cannot hold the parser
+    if (++_textLine > HW_TEXT_MAX_LINE)
+    {
+        _textError(byte);
+        return false;
+    }
+
+    // Outside of a line start '$' always means the frame was cut short
+    if (byte == HW_TEXT_MARK && _textState != HW_STATE_TEXT_LINE)
+    {
+        _textError(byte);
+        return false;
+    }
+
+    uint8_t digit;
+
+    switch (_textState)
+    {
+    case HW_STATE_TEXT_START:
+        if (byte != HW_TEXT_START)
+        {
+            _textError(byte);
+            return false;
+        }
+        _textSum ^= byte;
+        _frameType = HW_FRAME_KEYFRAME;
+        _encoding = HW_ENC_FLOAT32;
+        _beginFrame(HW_PROTO_VERSION_V2);
+        _textState = HW_STATE_TEXT_HEADER;
+        return false;
+
+    case HW_STATE_TEXT_HEADER:
+        _textSum ^= byte;
+        if (byte == '\n')
+        {
+            _textState = HW_STATE_TEXT_LINE;
+            _textLine = 0;
+        }
+        return false;
+
+    case HW_STATE_TEXT_LINE:
+        if (byte == HW_TEXT_MARK)
+        {
+            // The checksum covers everything before the end marker
+            _textState = HW_STATE_TEXT_MARK;
+            return false;
+        }
+        _textSum ^= byte;
+        if (byte == '\r' || byte == '\n')
+        {
+            _textLine = 0;
+            return false;
+        }
+        digit = hwHexDigit(byte);
+        if (digit > 0xF)
+        {
+            _textError(byte);
+            return false;
+        }
+        _textId = digit;
+        _textState = HW_STATE_TEXT_ID;
+        return false;
+
+    case HW_STATE_TEXT_ID:
+        _textSum ^= byte;
+        if (byte == ':')
+        {
+            _textMant = 0;
+            _textExp = 0;
+            _textDigits = 0;
+            _textFlags = 0;
+            _textState = HW_STATE_TEXT_VALUE;
+            return false;
+        }
+        digit = hwHexDigit(byte);
+        if (digit > 0xF || _textId > 0xFFF)
+        {
+            _textError(byte);
+            return false;
+        }
+        _textId = _textId << 4 | digit;
+        return false;
+
+    case HW_STATE_TEXT_VALUE:
+        _textSum ^= byte;
+        if (byte == '\n')
+        {
+            _textRecord();
+            _textState = HW_STATE_TEXT_LINE;
+            _textLine = 0;
+            return false;
+        }
+        _textValue(byte);
+        return false;
+
+    case HW_STATE_TEXT_MARK:
+        if (byte == HW_TEXT_START)
+        {
+            // "$S" before "$E", the old frame is lost but the new one is intact
+            _textError(HW_TEXT_MARK);
+            return _stepText(byte);
+        }
+        if (byte != HW_TEXT_END)
+        {
+            _textError(byte);
+            return false;
+        }
+        _textState = HW_STATE_TEXT_END_COLON;
+        return false;
+
+    case HW_STATE_TEXT_END_COLON:
+        if (byte != ':')
+        {
+            _textError(byte);
+            return false;
+        }
+        _textCheck = 0;
+        _textDigits = 0;
+        _textState = HW_STATE_TEXT_CHECKSUM;
+        return false;
+
+    case HW_STATE_TEXT_CHECKSUM:
+        if (byte == ' ' && _textDigits == 0)
+            return false;
+
+        digit = hwHexDigit(byte);
+        if (digit > 0xF)
+        {
+            _textError(byte);
+            return false;
+        }
+        _textCheck = _textCheck << 4 | digit;
+        if (++_textDigits < 2)
+            return false;
+
+        _textState = HW_STATE_TEXT_IDLE;
+
+        if (HAS_CRC && _textCheck != _textSum)
+        {
+            crcErrors++;
+            packetsError++;
+            _beginResync();
+            return false;
+        }
+
+        return _commitFrame(nullptr);
+
+    default:
+        _textState = HW_STATE_TEXT_IDLE;
+        return false;
+    }
+}
+
+HW_TEMPLATE
+void HW_MONITOR::_textValue(uint8_t byte)
+{
+    if (byte >= '0' && byte <= '9')
+    {
+        uint8_t digit = byte - '0';
+        _textFlags |= TEXT_DIGIT;
+
+        // Digits past float precision only move the decimal point
+        if (_textDigits < 9)
+        {
+            _textMant = _textMant * 10 + digit;
+            if (_textMant)
+                _textDigits++;
+            if (_textFlags & TEXT_POINT)
+                _textExp--;
+        }
+        else if (!(_textFlags & TEXT_POINT))
+        {
+            _textExp++;
+        }
+    }
+    else if ((byte == '.' || byte == ',') && !(_textFlags & TEXT_POINT))
+    {
+        // The host always sends '.'; older ones used the locale's comma
+        _textFlags |= TEXT_POINT;
+    }
+    else if ((byte == '-' || byte == '+') && !_textFlags)
+    {
+        _textFlags |= byte == '-' ? TEXT_SIGN | TEXT_NEG : TEXT_SIGN;
+    }
+    else if (byte != '\r' && byte != ' ')
+    {
+        _textFlags |= TEXT_BAD;
+    }
+}
+
+HW_TEMPLATE
+void HW_MONITOR::_textRecord()
+{
+    if ((_textFlags & TEXT_BAD) || !(_textFlags & TEXT_DIGIT))
+        return;
+
+    float value = (float)_textMant;
+    int8_t exp = _textExp;
+
+    // A line is at most HW_TEXT_MAX_LINE bytes, so this runs a few times at most
+    while (exp < -9)
+    {
+        value /= hwPow10[9];
+        exp += 9;
+    }
+    while (exp > 9)
+    {
+        value *= hwPow10[9];
+        exp -= 9;
+    }
+    if (exp < 0)
+    {
+        value /= hwPow10[-exp];
+    }
+    else
+    {
+        value *= hwPow10[exp];
+    }
+
+    if (_textFlags & TEXT_NEG)
+        value = -value;
+
+    // IDs wider than IdType cannot be stored
+    if ((IdType)_textId == _textId)
+    {
+        _store((IdType)_textId, value);
+    }
+}
+
+HW_TEMPLATE
+void HW_MONITOR::_textError(uint8_t byte)
+{
+    packetsError++;
+    _beginResync();
+
+    // The byte that broke this frame may start the next one
+    if (byte == HW_TEXT_MARK)
+    {
+        _textState = HW_STATE_TEXT_START;
+        _textSum = byte;
+        _textLine = 1;
+    }
+    else
+    {
+        _textState = HW_STATE_TEXT_IDLE;
+    }
+}
+
+/*===========================================================================*/
+/*  CHANGE DETECTION                                                         */
+/*===========================================================================*/
+
+HW_TEMPLATE
+void HW_MONITOR::_detectChanges(uint8_t count, bool relayout)
+{
+    if (!HAS_DEADBAND)
+    {
+        memcpy(_moved, _updated, VALID_BYTES);
+        return;
+    }
+
+    uint8_t back = _front ^ 1;
+
+    if (relayout || _bandsDirty)
+    {
+        _assignBands(back, count);
+        _bandsDirty = false;
+    }
+
+    // Only sensors the frame carried can have changed, 8 slots per mask byte
+    memset(_moved, 0, VALID_BYTES);
+    for (uint16_t base = 0; base < count; base += 8)
+    {
+        uint8_t bits = _updated[base >> 3];
+        for (uint8_t i = (uint8_t)base; bits && i < count; i++, bits >>= 1)
+        {
+            if (!(bits & 1))
+                continue;
+
+            float value = _values[back][i];
+
+            // New sensors, and every sensor after a relayout, always report
+            if (!relayout && hwBitTest(_valid[_front], i))
+            {
+                float last = _reported[i];
+                float band = 0.0f;
+                uint8_t r = _bandOf[i];
+
+                if (r != HW_INDEX_EMPTY)
+                {
+                    band = _bands[r].relative * fabsf(last);
+                    if (band < _bands[r].absolute)
+                        band = _bands[r].absolute;
+                }
+
+                if (fabsf(value - last) <= band)
+                    continue;
+            }
+
+            _reported[i] = value;
+            _moved[i >> 3] |= 1 << (i & 7);
+        }
+    }
+}
+
+HW_TEMPLATE
+void HW_MONITOR::_assignBands(uint8_t bank, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        HWSensorId id = _ids[bank][i];
+        uint8_t rule = HW_INDEX_EMPTY;
+        bool idRule = false;
+        bool categorized = false;
+        uint8_t category = HW_CATEGORY_NONE;
+
+        for (uint8_t r = 0; r < _bandCount && !idRule; r++)
+        {
+            if (_bands[r].id != SENSOR_UNKNOWN)
+            {
+                idRule = _bands[r].id == id;
+                if (idRule)
+                    rule = r;
+                continue;
+            }
+
+            // Resolving the role scans the role table, do it once per slot
+            if (!categorized)
+            {
+                category = _category(id);
+                categorized = true;
+            }
+            if (_bands[r].category == category)
+                rule = r;
+        }
+
+        _bandOf[i] = rule;
+    }
+}
+
+HW_TEMPLATE
+uint8_t HW_MONITOR::_category(HWSensorId id) const
+{
+    HWSensorId role = id;
+
+    if (HAS_META && _metaValid)
+    {
+        role = SENSOR_UNKNOWN;
+        for (uint8_t r = 1; r < ROLE_CAPACITY; r++)
+        {
+            if (_roleIds[r] == id)
+            {
+                role = r;
+                break;
+            }
+        }
+    }
+
+    return role < HW_ROLE_COUNT ? role >> 4 : HW_CATEGORY_NONE;
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::_addDeadband(HWSensorId id, uint8_t category, float absolute, float relative)
+{
+    uint8_t r = 0;
+    while (r < _bandCount && (_bands[r].id != id || _bands[r].category != category))
+    {
+        r++;
+    }
+
+    if (r == _bandCount)
+    {
+        if (_bandCount >= HW_MAX_DEADBANDS)
+            return false;
+        _bandCount++;
+    }
+
+    _bands[r].id = id;
+    _bands[r].category = category;
+    _bands[r].absolute = absolute;
+    _bands[r].relative = relative;
+    _bandsDirty = true;
+    return true;
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::setDeadband(HWSensorId id, float absolute, float relative)
+{
+    static_assert(HAS_DEADBAND, "setDeadband() needs HW_FEATURE_DEADBAND");
+    return _addDeadband(id, HW_CATEGORY_NONE, absolute, relative);
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::setCategoryDeadband(uint8_t category, float absolute, float relative)
+{
+    static_assert(HAS_DEADBAND, "setCategoryDeadband() needs HW_FEATURE_DEADBAND");
+    return _addDeadband(SENSOR_UNKNOWN, category, absolute, relative);
+}
+
+HW_TEMPLATE
+void HW_MONITOR::clearDeadbands()
+{
+    _bandCount = 0;
+    _bandsDirty = true;
+}
+
+/*===========================================================================*/
+/*  RESYNCHRONIZATION                                                        */
+/*===========================================================================*/
+
+HW_TEMPLATE
+void HW_MONITOR::_capture(const uint8_t *data, size_t len)
+{
+    if (!HAS_RESYNC && !HAS_COBS)
+        return;
+
+    if (_rxLen + len > RX_BUFFER_SIZE)
+    {
+        _rxOverflow = true;
+        return;
+    }
+
+    memcpy(_rxBuffer + _rxLen, data, len);
+    _rxLen += len;
+}
+
+HW_TEMPLATE
+void HW_MONITOR::_countDiscarded(size_t len)
+{
+    if (_resyncPending)
+    {
+        _resyncBytes += len;
+    }
+}
+
+HW_TEMPLATE
+void HW_MONITOR::_beginResync()
+{
+    if (!_resyncPending)
+    {
+        _resyncPending = true;
+        _resyncBytes = 0;
+        _resyncFrames = 0;
+        resync.events++;
+    }
+    _resyncFrames++;
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::_resync()
+{
+    bool packetReceived = false;
+    size_t from = 1; // skip the false START
+
+    _beginResync();
+
+    // Frame was longer than the lookback window, bytes are gone
+    if (!HAS_RESYNC || _rxOverflow)
+    {
+        _countDiscarded(_rxLen);
+        _rxLen = 0;
+        _state = HW_STATE_IDLE;
+        return false;
+    }
+
+    // Replay captured bytes from the next START candidate
+    while (true)
+    {
+        const uint8_t *start = nullptr;
+        if (from < _rxLen)
+        {
+            start = (const uint8_t *)memchr(_rxBuffer + from, HW_PROTO_START, _rxLen - from);
+        }
+
+        if (!start)
+        {
+            _countDiscarded(_rxLen);
+            _rxLen = 0;
+            _state = HW_STATE_IDLE;
+            return packetReceived;
+        }
+
+        size_t skip = start - _rxBuffer;
+        _countDiscarded(skip);
+        _rxLen -= skip;
+        memmove(_rxBuffer, start, _rxLen);
+
+        _state = HW_STATE_VERSION;
+
+        size_t i = 1;
+        StepResult result = STEP_CONTINUE;
+        while (i < _rxLen && (result = _step(_rxBuffer[i])) == STEP_CONTINUE)
+        {
+            i++;
+        }
+
+        if (result == STEP_CONTINUE)
+        {
+            // Candidate is still a valid frame prefix, keep collecting
+            return packetReceived;
+        }
+
+        if (result == STEP_FRAME)
+        {
+            packetReceived = true;
+            from = i + 1;
+            _state = HW_STATE_IDLE;
+        }
+        else
+        {
+            _resyncFrames++;
+            from = 1;
+        }
+    }
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::_cobsFrame(const uint8_t *src, size_t len)
+{
+    // Back-to-back delimiters, e.g. a sender flushing the line
+    if (src && len == 0)
+        return false;
+
+    size_t decoded = HW_COBS_ERROR;
+    size_t frameLen = 0;
+
+    if (src && len <= RX_BUFFER_SIZE)
+    {
+        decoded = hwCobsDecode(src, len, _rxBuffer);
+    }
+
+    // The whole decoded frame must be exactly one valid frame
+    if (decoded != HW_COBS_ERROR && decoded > 0 && _rxBuffer[0] == HW_PROTO_START &&
+        _checkFrame(_rxBuffer, decoded, &frameLen) == FRAME_OK && frameLen == decoded)
+    {
+        // Checked frames can still be refused, e.g. VALUES without their schema
+        return _decodeFrame(_rxBuffer);
+    }
+
+    // Nothing to search: the next frame starts after this delimiter
+    packetsError++;
+    _beginResync();
+    _countDiscarded(len + 1);
+    return false;
+}
+
+/*===========================================================================*/
+/*  BUFFER PARSER                                                            */
+/*===========================================================================*/
+
+HW_TEMPLATE
+bool HW_MONITOR::parse(const uint8_t *data, size_t len)
+{
+    return parseFrames(data, len) > 0;
+}
+
+HW_TEMPLATE
+size_t HW_MONITOR::parseFrames(const uint8_t *data, size_t len, size_t *consumed)
+{
+    size_t frames = 0;
+    size_t pos = 0;
+    const size_t none = (size_t)-1;
+    size_t incomplete = none; // first candidate that runs past the buffer
+
+    if (!data)
+        len = 0;
+
+    if (HAS_TEXT && _framing == HW_FRAMING_TEXT)
+    {
+        // Each call starts clean, a frame cut off at the end is left for the next
+        size_t start = len;
+        _textState = HW_STATE_TEXT_IDLE;
+
+        for (; pos < len; pos++)
+        {
+            if (_stepText(data[pos]))
+            {
+                frames++;
+            }
+            if (_textState == HW_STATE_TEXT_START)
+            {
+                start = pos;
+            }
+        }
+
+        if (consumed)
+        {
+            *consumed = _textState == HW_STATE_TEXT_IDLE ? len : start;
+        }
+        _textState = HW_STATE_TEXT_IDLE;
+        return frames;
+    }
+
+    if (_framing == HW_FRAMING_COBS)
+    {
+        // Each delimiter ends a frame, decoded straight into _rxBuffer
+        while (pos < len)
+        {
+            const uint8_t *delim = (const uint8_t *)memchr(data + pos, HW_COBS_DELIMITER, len - pos);
+            if (!delim)
+                break;
+
+            size_t n = delim - (data + pos);
+            if (_cobsFrame(data + pos, n))
+            {
+                frames++;
+            }
+            pos += n + 1;
+        }
+
+        if (consumed)
+        {
+            *consumed = pos;
+        }
+        return frames;
+    }
+
+    while (pos < len)
+    {
+        const uint8_t *pkt = (const uint8_t *)memchr(data + pos, HW_PROTO_START, len - pos);
+        if (!pkt)
+        {
+            pos = len;
+            break;
+        }
+
+        size_t offset = pkt - data;
+        size_t frameLen = 0;
+
+        switch (_checkFrame(pkt, len - offset, &frameLen))
+        {
+        case FRAME_OK:
+            // A later valid frame means the truncated candidate was a false start
+            if (incomplete != none)
+            {
+                incomplete = none;
+                packetsError++;
+            }
+
+            if (_decodeFrame(pkt))
+                frames++;
+            pos = offset + frameLen;
+            break;
+
+        case FRAME_INCOMPLETE:
+            // Keep scanning, a complete frame may follow a false start
+            if (incomplete == none)
+                incomplete = offset;
+            pos = offset + 1;
+            break;
+
+        default:
+            packetsError++;
+            pos = offset + 1;
+            break;
+        }
+    }
+
+    if (consumed)
+    {
+        *consumed = incomplete != none ? incomplete : pos;
+    }
+
+    return frames;
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::_decodeFrame(const uint8_t *pkt)
+{
+    uint8_t version = pkt[1];
+    uint8_t header = hwHeaderSize(version, pkt[2]);
+    uint8_t recordSize = hwRecordSize(version, pkt[2]);
+    uint8_t count = pkt[header - 1];
+    const uint8_t *record = pkt + header;
+
+    _frameType = HW_FRAME_KEYFRAME;
+    _encoding = HW_ENC_FLOAT32;
+    if (version == HW_PROTO_VERSION_V3)
+    {
+        _frameType = pkt[2] & HW_FRAME_KIND_MASK;
+        _encoding = pkt[2] & HW_ENC_MASK;
+        _frameSeq = pkt[3];
+        if (_frameType == HW_FRAME_VALUES)
+        {
+            _frameHash = pkt[4] | ((uint16_t)pkt[5] << 8);
+        }
+    }
+    _expectedCount = count;
+    _beginFrame(version);
+
+    if (_frameType == HW_FRAME_VALUES)
+    {
+        _decodeValues(record, count);
+    }
+    else
+    {
+        for (; _currentSensor < count; _currentSensor++, record += recordSize)
+        {
+            _decodeRecord(version, record);
+        }
+    }
+
+    return _commitFrame(pkt);
+}
+
+HW_TEMPLATE
+typename HW_MONITOR::FrameCheck HW_MONITOR::_checkFrame(const uint8_t *pkt, size_t avail, size_t *frameLen)
+{
+    if (avail < 3)
+        return FRAME_INCOMPLETE;
+
+    uint8_t version = pkt[1];
+    uint8_t recordSize = hwRecordSize(version, pkt[2]);
+    uint8_t header = hwHeaderSize(version, pkt[2]);
+
+    if (!recordSize)
+        return FRAME_BAD;
+
+    if (avail < header)
+        return FRAME_INCOMPLETE;
+
+    uint8_t count = pkt[header - 1];
+
+    if (count > hwMaxRecords(version, pkt[2]) || (count == 0 && version != HW_PROTO_VERSION_V3))
+        return FRAME_BAD;
+
+    size_t dataLen = (size_t)count * recordSize;
+    *frameLen = header + dataLen + 3;
+
+    if (avail < *frameLen)
+        return FRAME_INCOMPLETE;
+
+    if (pkt[*frameLen - 1] != HW_PROTO_END)
+        return FRAME_BAD;
+
+    // CRC over VERSION..last data byte, low byte first
+    if (HAS_CRC)
+    {
+        uint16_t received = pkt[header + dataLen] | ((uint16_t)pkt[header + 1 + dataLen] << 8);
+        if (hwCrc16(pkt + 1, header - 1 + dataLen) != received)
+        {
+            crcErrors++;
+            return FRAME_BAD;
+        }
+    }
+
+    return FRAME_OK;
+}
+
+/*===========================================================================*/
+/*  DATA ACCESS                                                              */
+/*===========================================================================*/
+
+HW_TEMPLATE
+float HW_MONITOR::get(HWSensorId id, float defaultValue) const
+{
+    float value = defaultValue;
+    _read([&](uint8_t front) {
+        uint8_t slot = _slot(id, front);
+        value = slot != HW_INDEX_EMPTY && hwBitTest(_valid[front], slot) ? _values[front][slot] : defaultValue;
+    });
+    return value;
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::isValid(HWSensorId id) const
+{
+    bool valid = false;
+    _read([&](uint8_t front) {
+        uint8_t slot = _slot(id, front);
+        valid = slot != HW_INDEX_EMPTY && hwBitTest(_valid[front], slot);
+    });
+    return valid;
+}
+
+HW_TEMPLATE
+typename HW_MONITOR::SensorView HW_MONITOR::getSensorByIndex(uint8_t index) const
+{
+    SensorView view;
+    _read([&](uint8_t front) {
+        view = index < _bankCount[front] ? _view(front, index) : SensorView();
+    });
+    return view;
+}
+
+HW_TEMPLATE
+typename HW_MONITOR::SensorView HW_MONITOR::findSensor(HWSensorId id) const
+{
+    SensorView view;
+    _read([&](uint8_t front) {
+        uint8_t slot = _slot(id, front);
+        view = slot != HW_INDEX_EMPTY ? _view(front, slot) : SensorView();
+    });
+    return view;
+}
+
+HW_TEMPLATE
+template <typename Read>
+bool HW_MONITOR::_read(Read &&read) const
+{
+    // Same seqlock as snapshot(). Both banks are complete while _seq is
+    // odd, only _front moves then. The bank that was read can only be
+    // refilled once a later publish has finished, two steps past the even
+    // count before the read; anything less needs no retry.
+    for (uint8_t attempt = 0; attempt < 8; attempt++)
+    {
+        HWSequence begin = _seq & ~(HWSequence)1;
+        HW_READ_BARRIER();
+
+        read(_front);
+
+        HW_READ_BARRIER();
+        if ((HWSequence)(_seq - begin) < 2)
+            return true;
+    }
+    return false;
+}
+
+HW_TEMPLATE
+uint8_t HW_MONITOR::_slot(HWSensorId id, uint8_t bank) const
+{
+    if ((IdType)id != id)
+        return HW_INDEX_EMPTY;
+
+    uint8_t slot = _index[bank].find((IdType)id, _ids[bank]);
+    return slot < _bankCount[bank] ? slot : HW_INDEX_EMPTY;
+}
+
+HW_TEMPLATE
+typename HW_MONITOR::SensorView HW_MONITOR::_view(uint8_t bank, uint8_t slot) const
+{
+    Sensor sensor;
+    sensor.id = _ids[bank][slot];
+    sensor.value = _values[bank][slot];
+    sensor.valid = hwBitTest(_valid[bank], slot);
+    sensor.timestamp = HAS_TIMESTAMPS ? _stamps[bank][slot] : _bankTime[bank];
+    return SensorView(sensor);
+}
+
+HW_TEMPLATE
+void HW_MONITOR::invalidateAll()
+{
+    uint8_t front = _front;
+
+    _seq = _seq + 1;
+    HW_BARRIER();
+    memset(_valid[front], 0, VALID_BYTES);
+    HW_BARRIER();
+    _seq = _seq + 1;
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::snapshot(Snapshot &out, uint8_t maxRetries) const
+{
+    for (uint8_t attempt = 0; attempt < maxRetries; attempt++)
+    {
+        HWSequence begin = _seq;
+        HW_BARRIER();
+
+        if (begin & 1)
+            continue;
+
+        uint8_t front = _front;
+        uint8_t count = _bankCount[front];
+        memcpy(out.ids, _ids[front], count * sizeof(IdType));
+        memcpy(out.values, _values[front], count * sizeof(float));
+        memcpy(out.valid, _valid[front], VALID_BYTES);
+        out.sensorCount = count;
+        out.lastUpdate = _bankTime[front];
+
+        HW_BARRIER();
+        if (_seq == begin)
+        {
+            out.sequence = begin;
+            return true;
+        }
+    }
+    return false;
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::getScale(HWSensorId id, float &scale, float &offset) const
+{
+    if (!HAS_SCALED || (IdType)id != id)
+        return false;
+
+    uint8_t s = _scaleIndex.find((IdType)id, _scaleIds);
+    if (s >= _scaleCount)
+        return false;
+
+    scale = _scaleMul[s];
+    offset = _scaleAdd[s];
+    return true;
+}
+
+HW_TEMPLATE
+const char *HW_MONITOR::getName(HWSensorId id) const
+{
+    // Fixed names only describe the fixed IDs, not ones the host assigned
+    if (!HAS_META || !_metaValid)
+        return hwGetSensorName(id);
+
+    uint8_t m = (IdType)id == id ? _metaIndex.find((IdType)id, _metaIds) : HW_INDEX_EMPTY;
+    if (m == HW_INDEX_EMPTY || _metaName[m] == META_NONE)
+        return "Unknown";
+
+    return _metaArena + _metaName[m];
+}
+
+HW_TEMPLATE
+const char *HW_MONITOR::getUnit(HWSensorId id) const
+{
+    if (!HAS_META || !_metaValid)
+        return hwGetSensorUnit(id);
+
+    uint8_t m = (IdType)id == id ? _metaIndex.find((IdType)id, _metaIds) : HW_INDEX_EMPTY;
+    if (m == HW_INDEX_EMPTY || _metaUnit[m] == META_NONE)
+        return "";
+
+    return _metaArena + _metaUnit[m];
+}
+
+HW_TEMPLATE
+HWSensorId HW_MONITOR::roleId(HWSensorId role) const
+{
+    if (!HAS_META || !_metaValid)
+        return role;
+
+    return role < HW_ROLE_COUNT ? _roleIds[role] : SENSOR_UNKNOWN;
+}
+
+HW_TEMPLATE
+bool HW_MONITOR::isStale(uint32_t timeoutMs) const
+{
+    if (lastUpdate == 0)
+        return true;
+    return (millis() - lastUpdate) > timeoutMs;
+}
+
+HW_TEMPLATE
+uint32_t HW_MONITOR::getAge() const
+{
+    if (lastUpdate == 0)
+        return UINT32_MAX;
+    return millis() - lastUpdate;
+}
+
+HW_TEMPLATE
+void HW_MONITOR::onPacket(HWPacketCallback callback)
+{
+    static_assert(HAS_CALLBACKS, "onPacket() needs HW_FEATURE_CALLBACKS");
+    _callbacks.packet = callback;
+}
+
+HW_TEMPLATE
+void HW_MONITOR::onSensor(HWSensorCallback callback)
+{
+    static_assert(HAS_CALLBACKS, "onSensor() needs HW_FEATURE_CALLBACKS");
+    _callbacks.sensor = callback;
+}
+
+HW_TEMPLATE
+void HW_MONITOR::onFrame(FrameCallback callback)
+{
+    static_assert(HAS_CALLBACKS, "onFrame() needs HW_FEATURE_CALLBACKS");
+    _callbacks.frame = callback;
+}
+
+HW_TEMPLATE
+void HW_MONITOR::onChange(HWSensorCallback callback)
+{
+    static_assert(HAS_CALLBACKS, "onChange() needs HW_FEATURE_CALLBACKS");
+    _callbacks.change = callback;
+}
+
+#undef HW_TEMPLATE
+#undef HW_MONITOR
+
+#endif // HW_MONITOR_IMPL_H
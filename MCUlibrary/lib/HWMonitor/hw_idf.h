@@ -0,0 +1,41 @@
+/**
+ * @file hw_idf.h
+ * @brief The few Arduino core pieces HWMonitor uses, for plain ESP-IDF
+ *
+ * Lets the C API (hw_monitor.h) build the same parser in an ESP-IDF
+ * project without the Arduino component. Stream only has what update()
+ * calls; IDF code feeds bytes with feed() or drain() instead.
+ */
+
+#ifndef HW_IDF_H
+#define HW_IDF_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_timer.h"
+
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+
+inline uint32_t millis()
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+inline uint32_t micros()
+{
+    return (uint32_t)esp_timer_get_time();
+}
+
+class Stream
+{
+public:
+    virtual ~Stream() {}
+
+    virtual int available() = 0;
+    virtual size_t readBytes(uint8_t *buffer, size_t length) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+};
+
+#endif // HW_IDF_H
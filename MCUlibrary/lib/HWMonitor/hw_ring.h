@@ -0,0 +1,251 @@
+/**
+ * @file hw_ring.h
+ * @brief Lock-free single-producer/single-consumer byte ring
+ *
+ * Sits between the receive path and the parser. The producer (UART ISR,
+ * USB receive callback, RX task) only moves head, the consumer (the task
+ * that parses) only moves tail, so neither side takes a lock or disables
+ * interrupts. Plain C, shared by hw_monitor.h and HWMonitor.h.
+ *
+ * Usage:
+ *   static uint8_t rx_storage[1024];
+ *   static hw_ring_t rx_ring;
+ *   hw_ring_init(&rx_ring, rx_storage, sizeof(rx_storage));
+ *
+ *   // producer
+ *   hw_ring_write(&rx_ring, data, len);
+ *
+ *   // consumer, bounded batch
+ *   hw_monitor_drain(mon, &rx_ring, 256);   or   monitor.drain(rx_ring, 256);
+ */
+
+#ifndef HW_RING_H
+#define HW_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================*/
+/*  CONFIGURATION                                                            */
+/*===========================================================================*/
+
+// Indices must load and store in one instruction, so 8-bit on AVR. Head and
+// tail run freely and wrap at the index width, which caps the ring at half
+// of it.
+#if defined(__AVR__)
+typedef uint8_t hw_ring_index_t;
+#define HW_RING_MAX_SIZE 128
+#else
+typedef uint16_t hw_ring_index_t;
+#define HW_RING_MAX_SIZE 32768
+#endif
+
+// Orders buffer accesses against the index that publishes them. A compiler
+// barrier is enough on single-core AVR; elsewhere the other side may run on
+// another core.
+// HW_READ_BARRIER() only keeps later loads after earlier ones, all a
+// reader retrying on a sequence count needs; free on x86.
+#if defined(__AVR__)
+#define HW_BARRIER() __asm__ __volatile__("" ::: "memory")
+#define HW_READ_BARRIER() HW_BARRIER()
+#else
+#define HW_BARRIER() __sync_synchronize()
+#define HW_READ_BARRIER() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#endif
+
+/*===========================================================================*/
+/*  DATA TYPES                                                               */
+/*===========================================================================*/
+
+/**
+ * @brief Byte ring, one producer and one consumer
+ *
+ * The counters are written by the producer only. Reading them from the
+ * consumer is safe; overflows is 32-bit and may tear on 8-bit MCUs.
+ */
+typedef struct {
+    uint8_t*                  buffer;
+    hw_ring_index_t           mask;       /**< size - 1, size is a power of two */
+    volatile hw_ring_index_t  head;       /**< Next write, producer only */
+    volatile hw_ring_index_t  tail;       /**< Next read, consumer only */
+    volatile hw_ring_index_t  high_water; /**< Most bytes ever waiting */
+    volatile uint32_t         overflows;  /**< Bytes dropped on a full ring */
+} hw_ring_t;
+
+/*===========================================================================*/
+/*  SETUP                                                                    */
+/*===========================================================================*/
+
+/**
+ * @brief Attach storage, before either side runs
+ * @param ring Ring to initialize
+ * @param buffer Storage, owned by the caller
+ * @param size Storage size, rounded down to a power of two up to HW_RING_MAX_SIZE
+ * @return false if fewer than 2 bytes are usable
+ */
+static inline bool hw_ring_init(hw_ring_t* ring, uint8_t* buffer, size_t size)
+{
+    size_t usable = 1;
+    while (usable * 2 <= size && usable * 2 <= HW_RING_MAX_SIZE) {
+        usable *= 2;
+    }
+
+    ring->buffer = buffer;
+    ring->mask = (hw_ring_index_t)(usable - 1);
+    ring->head = 0;
+    ring->tail = 0;
+    ring->high_water = 0;
+    ring->overflows = 0;
+    return buffer != NULL && usable >= 2;
+}
+
+/**
+ * @brief Usable capacity in bytes
+ */
+static inline size_t hw_ring_size(const hw_ring_t* ring)
+{
+    return (size_t)ring->mask + 1;
+}
+
+/**
+ * @brief Bytes waiting to be read, from either side
+ */
+static inline size_t hw_ring_count(const hw_ring_t* ring)
+{
+    return (hw_ring_index_t)(ring->head - ring->tail);
+}
+
+/*===========================================================================*/
+/*  PRODUCER                                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief Append bytes, call from the producer only (ISR safe)
+ *
+ * Whatever does not fit is dropped and counted in overflows; the parser
+ * sees a gap and resynchronizes like after line noise.
+ *
+ * @param ring Ring
+ * @param data Bytes to append
+ * @param len Number of bytes
+ * @return Number of bytes stored
+ */
+static inline size_t hw_ring_write(hw_ring_t* ring, const uint8_t* data, size_t len)
+{
+    hw_ring_index_t head = ring->head;
+    size_t used = (hw_ring_index_t)(head - ring->tail);
+    size_t space = hw_ring_size(ring) - used;
+    size_t n = len < space ? len : space;
+
+    /* At most two copies: up to the end of the storage, then from the start */
+    size_t offset = head & ring->mask;
+    size_t first = hw_ring_size(ring) - offset;
+    if (first > n) first = n;
+    memcpy(ring->buffer + offset, data, first);
+    memcpy(ring->buffer, data + first, n - first);
+
+    /* Bytes must land before the consumer can see the new head */
+    HW_BARRIER();
+    ring->head = (hw_ring_index_t)(head + n);
+
+    if (used + n > ring->high_water) {
+        ring->high_water = (hw_ring_index_t)(used + n);
+    }
+    if (n < len) {
+        ring->overflows += (uint32_t)(len - n);
+    }
+    return n;
+}
+
+/**
+ * @brief Append one byte, for byte-per-interrupt UARTs
+ * @return false if the ring was full and the byte was dropped
+ */
+static inline bool hw_ring_put(hw_ring_t* ring, uint8_t byte)
+{
+    return hw_ring_write(ring, &byte, 1) == 1;
+}
+
+/*===========================================================================*/
+/*  CONSUMER                                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief Longest run of waiting bytes that is contiguous in memory
+ *
+ * Lets the consumer parse in place; release the bytes with hw_ring_skip().
+ *
+ * @param ring Ring
+ * @param data Receives a pointer to the first waiting byte
+ * @return Number of contiguous bytes, 0 if the ring is empty
+ */
+static inline size_t hw_ring_peek(const hw_ring_t* ring, const uint8_t** data)
+{
+    hw_ring_index_t tail = ring->tail;
+    size_t used = (hw_ring_index_t)(ring->head - tail);
+
+    /* Head before the bytes it covers */
+    HW_BARRIER();
+
+    size_t offset = tail & ring->mask;
+    size_t run = hw_ring_size(ring) - offset;
+    *data = ring->buffer + offset;
+    return used < run ? used : run;
+}
+
+/**
+ * @brief Release bytes returned by hw_ring_peek(), consumer only
+ * @param ring Ring
+ * @param len Number of bytes, at most what hw_ring_peek() returned
+ */
+static inline void hw_ring_skip(hw_ring_t* ring, size_t len)
+{
+    /* Done reading before the producer may overwrite the slots */
+    HW_BARRIER();
+    ring->tail = (hw_ring_index_t)(ring->tail + len);
+}
+
+/**
+ * @brief Copy waiting bytes out, consumer only
+ * @param ring Ring
+ * @param out Destination
+ * @param max Destination size
+ * @return Number of bytes copied
+ */
+static inline size_t hw_ring_read(hw_ring_t* ring, uint8_t* out, size_t max)
+{
+    size_t total = 0;
+
+    /* The waiting bytes wrap at most once */
+    for (int pass = 0; pass < 2 && total < max; pass++) {
+        const uint8_t* data;
+        size_t n = hw_ring_peek(ring, &data);
+        if (n == 0) break;
+        if (n > max - total) n = max - total;
+
+        memcpy(out + total, data, n);
+        hw_ring_skip(ring, n);
+        total += n;
+    }
+    return total;
+}
+
+/**
+ * @brief Drop every waiting byte, consumer only
+ */
+static inline void hw_ring_clear(hw_ring_t* ring)
+{
+    ring->tail = ring->head;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HW_RING_H */
@@ -4,8 +4,10 @@
  */
 
 #include <stdio.h>
-#include "freertos/FreeRTOS. h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "driver/uart.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
@@ -18,6 +20,14 @@ static const char* TAG = "HW_MON";
 #define UART_RX_PIN    GPIO_NUM_16
 #define UART_BAUD      115200
 #define BUF_SIZE       1024
+#define RING_SIZE      4096
+#define PARSE_BATCH    512
+
+/* UART -> ring -> parser: receiving never waits for parsing, and the reverse */
+static uint8_t rx_storage[RING_SIZE];
+static hw_ring_t rx_ring;
+static QueueHandle_t uart_queue;
+static hw_monitor_t* monitor;
 
 static void uart_init(void)
 {
@@ -30,7 +40,7 @@ static void uart_init(void)
         .source_clk = UART_SCLK_DEFAULT,
     };
     
-    uart_driver_install(UART_PORT, BUF_SIZE * 2, 0, 0, NULL, 0);
+    uart_driver_install(UART_PORT, BUF_SIZE * 2, 0, 16, &uart_queue, 0);
     uart_param_config(UART_PORT, &cfg);
     uart_set_pin(UART_PORT, UART_TX_PIN, UART_RX_PIN, -1, -1);
     
@@ -38,45 +48,84 @@ static void uart_init(void)
              UART_TX_PIN, UART_RX_PIN, UART_BAUD);
 }
 
+/* Producer: wakes on UART_DATA and only copies bytes into the ring */
 static void uart_task(void* arg)
 {
     uint8_t buf[BUF_SIZE];
+    uart_event_t event;
     
     while (1) {
-        int len = uart_read_bytes(UART_PORT, buf, BUF_SIZE, pdMS_TO_TICKS(100));
+        if (!xQueueReceive(uart_queue, &event, portMAX_DELAY)) {
+            continue;
+        }
         
-        if (len > 0) {
-            /* Option 1: Parse complete buffer */
-            if (hw_monitor_parse(buf, len)) {
-                ESP_LOGI(TAG, "Packet OK (%d sensors)", hw_monitor.sensor_count);
-            }
-            
-            /* Option 2: Process byte-by-byte (for streaming)
-            for (int i = 0; i < len; i++) {
-                if (hw_monitor_process_byte(buf[i])) {
-                    ESP_LOGI(TAG, "Packet OK");
-                }
-            }
-            */
+        if (event.type == UART_FIFO_OVF || event.type == UART_BUFFER_FULL) {
+            uart_flush_input(UART_PORT);
+            xQueueReset(uart_queue);
+            continue;
+        }
+        
+        if (event.type != UART_DATA) {
+            continue;
+        }
+        
+        size_t left = event.size;
+        while (left > 0) {
+            int len = uart_read_bytes(UART_PORT, buf, left < BUF_SIZE ? left : BUF_SIZE, 0);
+            if (len <= 0) break;
+            hw_ring_write(&rx_ring, buf, len);  /* excess counted in rx_ring.overflows */
+            left -= len;
+        }
+    }
+}
+
+/* Consumer: parses at most PARSE_BATCH bytes per pass */
+static void parse_task(void* arg)
+{
+    bool stale = true;  /* Nothing to invalidate before the first packet */
+    
+    while (1) {
+        size_t frames = hw_monitor_drain(monitor, &rx_ring, PARSE_BATCH);
+        
+        if (frames > 0) {
+            stale = false;
+            hw_monitor_stats_t stats;
+            hw_monitor_get_stats(monitor, &stats);
+            ESP_LOGI(TAG, "%u packet(s) OK (%d sensors)", (unsigned)frames, stats.sensor_count);
         }
         
-        /* Timeout check */
-        if (hw_monitor_age_ms() > 5000) {
-            hw_monitor_invalidate_all();
+        /* Bytes still waiting: one tick for lower-priority tasks, then the next batch */
+        vTaskDelay(hw_ring_count(&rx_ring) ? 1 : pdMS_TO_TICKS(5));
+        
+        /* Timeout check, once per silence: each call publishes to the readers */
+        if (!stale && hw_monitor_age_ms(monitor) > 5000) {
+            hw_monitor_invalidate_all(monitor);
+            stale = true;
         }
     }
 }
 
+/* Runs beside parse_task: one snapshot per redraw keeps the screen on one packet */
 static void display_task(void* arg)
 {
+    static hw_snapshot_t snap;
+    
     while (1) {
-        float cpu_temp = hw_get_cpu_temp();
-        float cpu_load = hw_get_cpu_load();
-        float gpu_temp = hw_get_gpu_temp();
-        float gpu_load = hw_get_gpu_load();
-        float ram_load = hw_get_ram_load();
+        if (!hw_monitor_snapshot(monitor, &snap)) {
+            vTaskDelay(1);  /* Publishing the whole time - try again */
+            continue;
+        }
+        
+        float cpu_temp = hw_snapshot_role(&snap, SENSOR_CPU_TEMP_PKG);
+        float cpu_load = hw_snapshot_role(&snap, SENSOR_CPU_LOAD_TOTAL);
+        float gpu_temp = hw_snapshot_role(&snap, SENSOR_GPU_TEMP_CORE);
+        float gpu_load = hw_snapshot_role(&snap, SENSOR_GPU_LOAD_CORE);
+        float ram_load = hw_snapshot_role(&snap, SENSOR_RAM_LOAD);
         
         if (cpu_temp > -900) {
+            hw_monitor_stats_t stats;
+            hw_monitor_get_stats(monitor, &stats);
+            
             printf("\n");
             printf("╔═══════════════════════════════╗\n");
             printf("║     PC HARDWARE MONITOR       ║\n");
@@ -86,7 +135,10 @@ static void display_task(void* arg)
             printf("║ RAM: %5.1f%%                  ║\n", ram_load);
             printf("╠═══════════════════════════════╣\n");
             printf("║ Packets:  OK=%lu ERR=%lu       ║\n", 
-                   hw_monitor.packets_ok, hw_monitor. packets_err);
+                   (unsigned long)stats.packets_ok, (unsigned long)stats.packets_err);
+            printf("║ Ring: max %u/%u lost %lu      ║\n",
+                   (unsigned)rx_ring.high_water, (unsigned)hw_ring_size(&rx_ring),
+                   (unsigned long)rx_ring.overflows);
             printf("╚═══════════════════════════════╝\n");
         } else {
             printf("Waiting for data from PC...\n");
@@ -100,10 +152,12 @@ void app_main(void)
 {
     ESP_LOGI(TAG, "Hardware Monitor starting...");
     
-    hw_monitor_init();
+    monitor = hw_monitor_init(0);
+    hw_ring_init(&rx_ring, rx_storage, sizeof(rx_storage));
     uart_init();
     
-    xTaskCreate(uart_task, "uart", 4096, NULL, 10, NULL);
+    xTaskCreate(uart_task, "uart", 4096, NULL, 12, NULL);
+    xTaskCreate(parse_task, "parse", 4096, NULL, 10, NULL);
     xTaskCreate(display_task, "display", 4096, NULL, 5, NULL);
     
     ESP_LOGI(TAG, "Ready!");
@@ -0,0 +1,106 @@
+/**
+ * @file dashboard.h
+ * @brief Układ ekranu z main_with_display.cpp jako widgety HWDisplay
+ *
+ * Wspólny dla szkicu z TFT i dla display_bench.cpp, więc benchmark mierzy
+ * dokładnie ten ekran, który rysuje urządzenie.
+ */
+
+#ifndef DASHBOARD_H
+#define DASHBOARD_H
+
+#include "HWDisplay.h"
+
+/* Kolory */
+#define BG_COLOR      HW_COLOR_BLACK
+#define TITLE_COLOR   HW_COLOR_CYAN
+#define LABEL_COLOR   HW_COLOR_WHITE
+#define STATS_COLOR   HW_COLOR_DARKGREY
+
+struct DashboardData
+{
+    float cpuTemp;
+    float cpuLoad;
+    float gpuTemp;
+    float gpuLoad;
+    float ramLoad;
+    uint32_t packetsOk;
+    uint32_t packetsErr;
+};
+
+class Dashboard
+{
+public:
+    Dashboard()
+        : title(10, 10, 10, 2, TITLE_COLOR),
+          cpuLabel(10, 50, 4), gpuLabel(10, 80, 4), ramLabel(10, 110, 4),
+          cpuTemp(70, 50, 6, 1, "C"), gpuTemp(70, 80, 6, 1, "C"),
+          cpuLoad(260, 50, 4, 0, "%"), gpuLoad(260, 80, 4, 0, "%"), ramLoad(230, 110, 4, 0, "%"),
+          cpuBar(150, 50, 100, 16), gpuBar(150, 80, 100, 16), ramBar(70, 110, 150, 16),
+          stats(10, 150, 30, 1, STATS_COLOR)
+    {
+        title.set("PC MONITOR");
+        cpuLabel.set("CPU:");
+        gpuLabel.set("GPU:");
+        ramLabel.set("RAM:");
+
+        cpuTemp.setThresholds(70, 85);
+        gpuTemp.setThresholds(70, 85);
+    }
+
+    void attach(HWScreen &screen)
+    {
+        HWWidget *widgets[] = {&title, &cpuLabel, &gpuLabel, &ramLabel, &cpuTemp, &gpuTemp,
+                               &cpuLoad, &gpuLoad, &ramLoad, &cpuBar, &gpuBar, &ramBar, &stats};
+        for (HWWidget *w : widgets) {
+            screen.add(*w);
+        }
+    }
+
+    /* Tylko ustawia wartości - rysuje HWScreen::render(), i to tylko zmiany */
+    void update(const DashboardData &d)
+    {
+        cpuTemp.set(d.cpuTemp);
+        cpuLoad.set(d.cpuLoad);
+        cpuBar.set(d.cpuLoad, loadColor(d.cpuLoad));
+
+        gpuTemp.set(d.gpuTemp);
+        gpuLoad.set(d.gpuLoad);
+        gpuBar.set(d.gpuLoad, loadColor(d.gpuLoad));
+
+        ramLoad.set(d.ramLoad);
+        ramBar.set(d.ramLoad, loadColor(d.ramLoad));
+
+        /* "Packets: 123 OK / 0 ERR" bez String i bez sterty */
+        char line[HW_WIDGET_TEXT_SIZE];
+        size_t n = hwFormatText(line, sizeof(line), "Packets: ");
+        n += hwFormatUint(line + n, sizeof(line) - n, d.packetsOk);
+        n += hwFormatText(line + n, sizeof(line) - n, " OK / ");
+        n += hwFormatUint(line + n, sizeof(line) - n, d.packetsErr);
+        hwFormatText(line + n, sizeof(line) - n, " ERR");
+        stats.set(line);
+    }
+
+    static uint16_t loadColor(float load)
+    {
+        if (load >= 90) return HW_COLOR_RED;
+        if (load >= 70) return HW_COLOR_YELLOW;
+        return HW_COLOR_GREEN;
+    }
+
+    HWLabel title;
+    HWLabel cpuLabel;
+    HWLabel gpuLabel;
+    HWLabel ramLabel;
+    HWValue cpuTemp;
+    HWValue gpuTemp;
+    HWValue cpuLoad;
+    HWValue gpuLoad;
+    HWValue ramLoad;
+    HWBar cpuBar;
+    HWBar gpuBar;
+    HWBar ramBar;
+    HWLabel stats;
+};
+
+#endif // DASHBOARD_H
@@ -0,0 +1,123 @@
+/**
+ * @file display_bench.cpp
+ * @brief Benchmark ekranu z main_with_display.cpp na HWFramebuffer
+ *
+ * Ten sam Dashboard co na TFT, rysowany do pamięci. Syntetyczne odczyty
+ * (temperatury dryfują powoli, obciążenia skaczą) co 250 ms ekranu, dla:
+ *  - render()   - tylko zmienione fragmenty widgetów,
+ *  - full       - wszystkie widgety od nowa co klatkę, jak stary updateDisplay().
+ * Raportuje czas renderu, piksele i wywołania na klatkę oraz szacowany czas
+ * SPI. Na koniec sprawdza, że oba tryby dają identyczny obraz.
+ * Wyniki na Serial.
+ */
+
+#include <Arduino.h>
+#include "HWMonitor.h"
+#include "dashboard.h"
+
+#define BENCH_WIDTH       320
+#define BENCH_HEIGHT      240
+#define BENCH_FRAMES      1000
+#define BENCH_SPI_HZ      40000000UL
+
+static uint16_t pixels[BENCH_WIDTH * BENCH_HEIGHT];
+
+/* Deterministyczny LCG - oba tryby dostają te same odczyty */
+static uint32_t rngState;
+
+static float rnd()
+{
+    rngState = rngState * 1664525UL + 1013904223UL;
+    return (rngState >> 8) * (1.0f / 16777216.0f);
+}
+
+static void makeData(int frame, DashboardData& d)
+{
+    static float cpuLoad, gpuLoad;
+    if (frame == 0) {
+        rngState = 12345;
+        cpuLoad = 20;
+        gpuLoad = 5;
+    }
+
+    /* Obciążenie: błądzenie losowe, co ~20 klatek skok */
+    cpuLoad += (rnd() - 0.5f) * 4;
+    gpuLoad += (rnd() - 0.5f) * 2;
+    if (rnd() < 0.05f) cpuLoad = rnd() * 100;
+    if (rnd() < 0.05f) gpuLoad = rnd() * 100;
+    cpuLoad = cpuLoad < 0 ? 0 : cpuLoad > 100 ? 100 : cpuLoad;
+    gpuLoad = gpuLoad < 0 ? 0 : gpuLoad > 100 ? 100 : gpuLoad;
+
+    d.cpuTemp = 55 + 15 * sinf(frame / 80.0f) + (rnd() - 0.5f) * 0.1f;
+    d.cpuLoad = cpuLoad;
+    d.gpuTemp = 45 + 20 * sinf(frame / 120.0f) + (rnd() - 0.5f) * 0.1f;
+    d.gpuLoad = gpuLoad;
+    d.ramLoad = 40 + frame * 0.01f;
+    d.packetsOk = frame * 4;
+    d.packetsErr = frame / 300;
+}
+
+static void benchRender(const char* name, bool full)
+{
+    HWFramebuffer fb(pixels, BENCH_WIDTH, BENCH_HEIGHT);
+    HWScreen screen(fb, BG_COLOR);
+    Dashboard dashboard;
+    DashboardData data;
+
+    dashboard.attach(screen);
+    screen.render();
+    fb.resetStats();
+
+    uint32_t us = 0;
+    uint32_t maxPixels = 0;
+
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        makeData(f, data);
+        uint32_t t0 = micros();
+
+        if (full) {
+            screen.invalidate(false);
+        }
+        dashboard.update(data);
+        uint32_t pushed = screen.render();
+
+        us += micros() - t0;
+        if (pushed > maxPixels) maxPixels = pushed;
+    }
+
+    float pixelsPerFrame = (float)fb.stats.pixels / BENCH_FRAMES;
+    Serial.printf("%-8s %7.2f us/frame  %8.0f px/frame (max %lu)  %5.1f calls/frame  %6.2f ms SPI\n",
+                  name, (float)us / BENCH_FRAMES, pixelsPerFrame, (unsigned long)maxPixels,
+                  (float)(fb.stats.rects + fb.stats.texts) / BENCH_FRAMES,
+                  pixelsPerFrame * 16 * 1000.0f / BENCH_SPI_HZ);
+}
+
+static uint16_t checksum()
+{
+    return hwCrc16((const uint8_t*)pixels, sizeof(pixels));
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    delay(2000);
+
+    Serial.println();
+    Serial.println("=== HWDisplay render benchmark ===");
+    Serial.printf("Screen: %dx%d RGB565, %d frames, SPI %lu MHz\n",
+                  BENCH_WIDTH, BENCH_HEIGHT, BENCH_FRAMES, BENCH_SPI_HZ / 1000000UL);
+}
+
+void loop()
+{
+    benchRender("render", false);
+    uint16_t dirtyCrc = checksum();
+    benchRender("full", true);
+    uint16_t fullCrc = checksum();
+
+    Serial.printf("image    %s (crc %04X / %04X)\n",
+                  dirtyCrc == fullCrc ? "identical" : "DIFFERENT", dirtyCrc, fullCrc);
+    Serial.println();
+
+    delay(5000);
+}
@@ -1,61 +1,153 @@
+/**
+ * @file hw_monitor.cpp
+ * @brief C interface over HWMonitorT, one context per port
+ */
+
+#include "HWMonitor.h"
 #include "hw_monitor.h"
 
-HWMonitor hw_monitor;
+#include <new>
+
+// Features of every C context, everything the platform default has
+#ifndef HW_MONITOR_FEATURES
+#define HW_MONITOR_FEATURES HW_FEATURES_DEFAULT
+#endif
 
-void hw_monitor_init()
+static_assert(sizeof(hw_sensor_id_t) == sizeof(HWSensorId), "hw_sensor_id_t must match HWSensorId");
+static_assert(sizeof(((hw_snapshot_t *)0)->valid) == hwBitmaskSize(HW_MONITOR_MAX_SENSORS), "hw_snapshot_t valid mask size");
+static_assert(HW_MONITOR_ROLE_COUNT == HW_ROLE_COUNT, "HW_MONITOR_ROLE_COUNT must match HW_ROLE_COUNT");
+static_assert(HW_MONITOR_FRAMING_RAW == (int)HW_FRAMING_RAW &&
+                  HW_MONITOR_FRAMING_COBS == (int)HW_FRAMING_COBS &&
+                  HW_MONITOR_FRAMING_TEXT == (int)HW_FRAMING_TEXT,
+              "hw_monitor_framing_t must match HWFraming");
+
+struct hw_monitor : HWMonitorT<HW_MONITOR_MAX_SENSORS, HWSensorId, HW_MONITOR_FEATURES>
 {
-    memset(&hw_monitor, 0, sizeof(hw_monitor));
-    for (int i = 0; i < HW_MAX_SENSORS; i++) {
-        hw_monitor.sensors[i].id = 0xFF;
-        hw_monitor.sensors[i].value = -999.0f;
-        hw_monitor.sensors[i].valid = false;
+};
+
+// Raw storage, constructed by hw_monitor_init(): no global constructor,
+// and the linker drops it when nothing calls the C API
+alignas(hw_monitor) static uint8_t ports[HW_MONITOR_PORTS][sizeof(hw_monitor)];
+static bool portReady[HW_MONITOR_PORTS];
+
+hw_monitor_t *hw_monitor_init(uint8_t port)
+{
+    if (port >= HW_MONITOR_PORTS)
+        return nullptr;
+
+    hw_monitor *mon = reinterpret_cast<hw_monitor *>(ports[port]);
+    if (!portReady[port])
+    {
+        new (mon) hw_monitor();
+        portReady[port] = true;
     }
+
+    mon->begin();
+    return mon;
+}
+
+bool hw_monitor_set_framing(hw_monitor_t *mon, hw_monitor_framing_t framing)
+{
+    return mon->setFraming((HWFraming)framing);
 }
 
-bool hw_monitor_parse(const uint8_t* data, size_t len)
+bool hw_monitor_process_byte(hw_monitor_t *mon, uint8_t byte)
 {
-    if (! data || len < 6) return false;
-    if (data[0] != HW_PROTO_START) return false;
-    if (data[1] != HW_PROTO_VERSION) return false;
-    
-    uint8_t count = data[2];
-    size_t expected = 3 + (count * 5) + 3;
-    
-    if (len < expected) return false;
-    if (data[expected - 1] != HW_PROTO_END) {
-        hw_monitor.packets_err++;
+    return mon->processByte(byte);
+}
+
+bool hw_monitor_parse(hw_monitor_t *mon, const uint8_t *data, size_t len)
+{
+    return data && mon->feed(data, len);
+}
+
+size_t hw_monitor_parse_frames(hw_monitor_t *mon, const uint8_t *data, size_t len, size_t *consumed)
+{
+    return mon->parseFrames(data, data ? len : 0, consumed);
+}
+
+size_t hw_monitor_drain(hw_monitor_t *mon, hw_ring_t *ring, size_t max_bytes)
+{
+    uint32_t before = mon->packetsOK;
+    mon->drain(*ring, max_bytes);
+    return mon->packetsOK - before;
+}
+
+float hw_monitor_get(const hw_monitor_t *mon, hw_sensor_id_t id)
+{
+    return mon->get(id);
+}
+
+bool hw_monitor_valid(const hw_monitor_t *mon, hw_sensor_id_t id)
+{
+    return mon->isValid(id);
+}
+
+bool hw_monitor_find(const hw_monitor_t *mon, hw_sensor_id_t id, hw_sensor_data_t *out)
+{
+    hw_monitor::SensorView sensor = mon->findSensor(id);
+    if (!sensor)
         return false;
-    }
-    
-    size_t offset = 3;
-    for (uint8_t i = 0; i < count && i < HW_MAX_SENSORS; i++) {
-        hw_monitor.sensors[i].id = data[offset];
-        
-        union { float f; uint8_t b[4]; } conv;
-        conv. b[0] = data[offset + 1];
-        conv.b[1] = data[offset + 2];
-        conv.b[2] = data[offset + 3];
-        conv.b[3] = data[offset + 4];
-        
-        hw_monitor.sensors[i].value = conv.f;
-        hw_monitor.sensors[i].valid = true;
-        
-        offset += 5;
-    }
-    
-    hw_monitor.sensor_count = count;
-    hw_monitor.packets_ok++;
-    hw_monitor.last_update = millis();
-    
+
+    out->id = sensor->id;
+    out->value = sensor->value;
+    out->valid = sensor->valid;
+    out->timestamp_ms = sensor->timestamp;
     return true;
 }
 
-float hw_monitor_get(uint8_t id)
+hw_sensor_id_t hw_monitor_role_id(const hw_monitor_t *mon, hw_sensor_id_t role)
+{
+    return mon->roleId(role);
+}
+
+void hw_monitor_invalidate_all(hw_monitor_t *mon)
+{
+    mon->invalidateAll();
+}
+
+uint32_t hw_monitor_age_ms(const hw_monitor_t *mon)
+{
+    return mon->getAge();
+}
+
+void hw_monitor_get_stats(const hw_monitor_t *mon, hw_monitor_stats_t *stats)
+{
+    stats->packets_ok = mon->packetsOK;
+    stats->packets_err = mon->packetsError;
+    stats->crc_errors = mon->crcErrors;
+    stats->resync_events = mon->resync.events;
+    stats->last_update_ms = mon->lastUpdate;
+    stats->sensor_count = mon->sensorCount;
+}
+
+bool hw_monitor_snapshot(const hw_monitor_t *mon, hw_snapshot_t *out)
 {
-    for (int i = 0; i < hw_monitor.sensor_count; i++) {
-        if (hw_monitor.sensors[i].id == id && hw_monitor.sensors[i].valid) {
-            return hw_monitor.sensors[i].value;
+    hw_monitor::Snapshot snap;
+
+    // Roles are resolved after the copy; a META frame in between moves the sequence
+    for (uint8_t attempt = 0; attempt < 8; attempt++)
+    {
+        if (!mon->snapshot(snap))
+            return false;
+
+        for (uint8_t r = 0; r < HW_MONITOR_ROLE_COUNT; r++)
+        {
+            out->role_ids[r] = mon->roleId(r);
         }
+
+        HW_READ_BARRIER();
+        if (mon->sequence() != snap.sequence)
+            continue;
+
+        uint8_t count = snap.sensorCount;
+        memcpy(out->ids, snap.ids, count * sizeof(hw_sensor_id_t));
+        memcpy(out->values, snap.values, count * sizeof(float));
+        memcpy(out->valid, snap.valid, sizeof(out->valid));
+        out->sensor_count = count;
+        out->last_update_ms = snap.lastUpdate;
+        out->sequence = snap.sequence;
+        return true;
     }
-    return -999.0f;
-}
\ No newline at end of file
+    return false;
+}
@@ -28,9 +28,17 @@ void onPacketReceived(uint8_t sensorCount)
 }
 
 // Callback wywoływany dla każdego sensora (opcjonalnie)
-void onSensorUpdate(uint8_t id, float value)
+void onSensorUpdate(HWSensorId id, float value)
 {
-    // DEBUG_SERIAL.printf("  Sensor 0x%02X = %.1f\n", id, value);
+    // DEBUG_SERIAL.printf("  Sensor 0x%04X = %.1f\n", id, value);
+}
+
+// Callback wywoływany raz na ramkę, tylko zmienione sensory (opcjonalnie)
+void onFrameReceived(const HWMonitor::FrameView &frame)
+{
+    // frame.forEachChanged([](HWSensorId id, float value) {
+    //     DEBUG_SERIAL.printf("  Sensor 0x%04X = %.1f\n", id, value);
+    // });
 }
 
 void setup()
@@ -57,7 +65,18 @@ void setup()
     // Initialize monitor
     monitor.begin();
     monitor.onPacket(onPacketReceived);
+    monitor.enableFlowControl();  // ACK/NACK z kredytami do PC (protokół v3)
+
+    // Tylko sensory czytane w szkicu - PC wyśle mniejsze ramki
+    // static const HWSensorId wanted[] = {SENSOR_CPU_TEMP, SENSOR_CPU_LOAD, SENSOR_GPU_TEMP, SENSOR_GPU_LOAD, SENSOR_RAM_LOAD};
+    // monitor.subscribe(wanted, sizeof(wanted) / sizeof(wanted[0]));
     // monitor.onSensor(onSensorUpdate);  // Uncomment for per-sensor callbacks
+    // monitor.onFrame(onFrameReceived);  // Uncomment for one call per frame
+
+    // Zmiany mniejsze niż martwa strefa nie liczą się jako zmiana (onChange, changedMask)
+    // monitor.setDeadband(SENSOR_CPU_TEMP, 0.5f);
+    // monitor.setCategoryDeadband(HW_CATEGORY_GPU, 0, 0.02f);
+    // monitor.onChange(onSensorUpdate);  // Uncomment for changed sensors only
     
     DEBUG_SERIAL.println("[OK] Ready!  Waiting for data...");
     DEBUG_SERIAL. println();
@@ -117,13 +136,13 @@ void listAllSensors()
     DEBUG_SERIAL. println("\n=== ALL SENSORS ===");
     
     for (uint8_t i = 0; i < monitor.sensorCount; i++) {
-        const HWSensor* sensor = monitor.getSensorByIndex(i);
+        HWMonitor::SensorView sensor = monitor.getSensorByIndex(i);
         if (sensor && sensor->valid) {
-            DEBUG_SERIAL.printf("[0x%02X] %-20s = %8.1f %s\n",
+            DEBUG_SERIAL.printf("[0x%04X] %-20s = %8.1f %s\n",
                                sensor->id,
-                               hwGetSensorName(sensor->id),
+                               monitor.getName(sensor->id),
                                sensor->value,
-                               hwGetSensorUnit(sensor->id));
+                               monitor.getUnit(sensor->id));
         }
     }
     
@@ -3,151 +3,129 @@
  * @brief Wersja z wyświetlaczem TFT (np. ST7789, ILI9341)
  */
 
-#include <Arduino. h>
+#include <Arduino.h>
 #include <USB.h>
-#include <USBCDC. h>
+#include <USBCDC.h>
 #include <TFT_eSPI.h>
 #include "hw_monitor.h"
+#include "dashboard.h"
 
 USBCDC USBSerial;
 TFT_eSPI tft;
 
-/* Kolory */
-#define BG_COLOR      TFT_BLACK
-#define TITLE_COLOR   TFT_CYAN
-#define LABEL_COLOR   TFT_WHITE
-#define VALUE_COLOR   TFT_GREEN
-#define WARN_COLOR    TFT_YELLOW
-#define CRIT_COLOR    TFT_RED
+/* Odbiór USB -> ring -> loop(): rysowanie nie opóźnia odbioru */
+#define RX_BATCH 512
+static uint8_t rxStorage[4096];
+static hw_ring_t rxRing;
+static hw_monitor_t *monitor;
+
+/* HWCanvas nad TFT_eSPI - font 1 (6x8) z tłem, jak zakłada HWDisplay */
+class TftCanvas : public HWCanvas
+{
+public:
+    explicit TftCanvas(TFT_eSPI &tft) : _tft(tft) {}
+
+    int16_t width() const override { return _tft.width(); }
+    int16_t height() const override { return _tft.height(); }
+
+protected:
+    void _fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override
+    {
+        _tft.fillRect(x, y, w, h, color);
+    }
+
+    void _drawText(int16_t x, int16_t y, const char *text, uint16_t fg, uint16_t bg, uint8_t size) override
+    {
+        _tft.setTextFont(1);
+        _tft.setTextSize(size);
+        _tft.setTextColor(fg, bg);
+        _tft.drawString(text, x, y);
+    }
+
+private:
+    TFT_eSPI &_tft;
+};
+
+TftCanvas canvas(tft);
+HWScreen screen(canvas, BG_COLOR);
+Dashboard dashboard;
+
+/* Wywoływane z zadania USB, tylko kopiuje bajty do ringu */
+static void onUsbEvent(void *arg, esp_event_base_t base, int32_t id, void *eventData)
+{
+    if (id != ARDUINO_USB_CDC_RX_EVENT)
+        return;
+
+    arduino_usb_cdc_event_data_t *data = (arduino_usb_cdc_event_data_t *)eventData;
+    uint8_t buf[64];
+    size_t left = data->rx.len;
+
+    while (left > 0) {
+        size_t n = USBSerial.read(buf, left < sizeof(buf) ? left : sizeof(buf));
+        if (n == 0) break;
+        hw_ring_write(&rxRing, buf, n); /* nadmiar liczy rxRing.overflows */
+        left -= n;
+    }
+}
 
 void setup()
 {
     Serial.begin(115200);
     
     /* TFT */
-    tft. init();
+    tft.init();
     tft.setRotation(1);
-    tft.fillScreen(BG_COLOR);
-    tft.setTextColor(TITLE_COLOR, BG_COLOR);
-    tft.setTextSize(2);
-    tft.drawString("PC MONITOR", 10, 10);
+    dashboard.attach(screen);
+    screen.render();
     
     /* USB */
+    hw_ring_init(&rxRing, rxStorage, sizeof(rxStorage));
+    USBSerial.onEvent(ARDUINO_USB_CDC_RX_EVENT, onUsbEvent);
     USBSerial.begin();
     USB.begin();
     
-    hw_monitor_init();
+    monitor = hw_monitor_init(0);
     
     Serial.println("Ready!");
 }
 
-uint32_t getColorForTemp(float temp)
-{
-    if (temp >= 85) return CRIT_COLOR;
-    if (temp >= 70) return WARN_COLOR;
-    return VALUE_COLOR;
-}
-
-uint32_t getColorForLoad(float load)
-{
-    if (load >= 90) return CRIT_COLOR;
-    if (load >= 70) return WARN_COLOR;
-    return VALUE_COLOR;
-}
-
-void drawBar(int x, int y, int w, int h, float value, uint32_t color)
-{
-    int fill = (int)(value * w / 100.0f);
-    if (fill > w) fill = w;
-    if (fill < 0) fill = 0;
-    
-    tft.fillRect(x, y, w, h, TFT_DARKGREY);
-    tft.fillRect(x, y, fill, h, color);
-    tft.drawRect(x, y, w, h, TFT_WHITE);
-}
-
 void updateDisplay()
 {
     static unsigned long lastUpdate = 0;
     if (millis() - lastUpdate < 250) return;
     lastUpdate = millis();
     
-    float cpu_temp = hw_get_cpu_temp();
-    float cpu_load = hw_get_cpu_load();
-    float gpu_temp = hw_get_gpu_temp();
-    float gpu_load = hw_get_gpu_load();
-    float ram_load = hw_get_ram_load();
-    
-    int y = 50;
-    
-    /* CPU */
-    tft.setTextColor(LABEL_COLOR, BG_COLOR);
-    tft.drawString("CPU:", 10, y);
-    
-    if (cpu_temp > -900) {
-        tft.setTextColor(getColorForTemp(cpu_temp), BG_COLOR);
-        tft.drawString(String(cpu_temp, 1) + "C  ", 70, y);
-        
-        drawBar(150, y, 100, 16, cpu_load, getColorForLoad(cpu_load));
-        
-        tft.setTextColor(VALUE_COLOR, BG_COLOR);
-        tft.drawString(String(cpu_load, 0) + "% ", 260, y);
-    } else {
-        tft.setTextColor(TFT_DARKGREY, BG_COLOR);
-        tft.drawString("--.-C    ", 70, y);
-    }
-    
-    y += 30;
-    
-    /* GPU */
-    tft.setTextColor(LABEL_COLOR, BG_COLOR);
-    tft. drawString("GPU:", 10, y);
-    
-    if (gpu_temp > -900) {
-        tft.setTextColor(getColorForTemp(gpu_temp), BG_COLOR);
-        tft.drawString(String(gpu_temp, 1) + "C  ", 70, y);
-        
-        drawBar(150, y, 100, 16, gpu_load, getColorForLoad(gpu_load));
-        
-        tft.setTextColor(VALUE_COLOR, BG_COLOR);
-        tft.drawString(String(gpu_load, 0) + "% ", 260, y);
-    }
-    
-    y += 30;
-    
-    /* RAM */
-    tft.setTextColor(LABEL_COLOR, BG_COLOR);
-    tft. drawString("RAM:", 10, y);
-    
-    if (ram_load > -900) {
-        drawBar(70, y, 150, 16, ram_load, getColorForLoad(ram_load));
-        
-        tft.setTextColor(VALUE_COLOR, BG_COLOR);
-        tft.drawString(String(ram_load, 0) + "% ", 230, y);
-    }
-    
-    y += 40;
-    
-    /* Stats */
-    tft.setTextSize(1);
-    tft.setTextColor(TFT_DARKGREY, BG_COLOR);
-    tft.drawString("Packets:  " + String(hw_monitor.packets_ok) + 
-                   " OK / " + String(hw_monitor.packets_err) + " ERR  ", 10, y);
-    tft.setTextSize(2);
+    hw_monitor_stats_t stats;
+    hw_monitor_get_stats(monitor, &stats);
+
+    DashboardData data;
+    data.cpuTemp = hw_get_cpu_temp(monitor);
+    data.cpuLoad = hw_get_cpu_load(monitor);
+    data.gpuTemp = hw_get_gpu_temp(monitor);
+    data.gpuLoad = hw_get_gpu_load(monitor);
+    data.ramLoad = hw_get_ram_load(monitor);
+    data.packetsOk = stats.packets_ok;
+    data.packetsErr = stats.packets_err;
+    
+    /* Widgety same wiedzą, co się zmieniło - przez SPI idą tylko te piksele */
+    dashboard.update(data);
+    screen.render();
 }
 
 void loop()
 {
-    /* Process USB data */
-    while (USBSerial.available()) {
-        if (hw_monitor_process_byte(USBSerial.read())) {
-            Serial.printf("Packet OK:  %d sensors\n", hw_monitor.sensor_count);
-        }
+    /* Parsowanie porcjami - reszta czeka w ringu do następnego obrotu */
+    if (hw_monitor_drain(monitor, &rxRing, RX_BATCH) > 0) {
+        hw_monitor_stats_t stats;
+        hw_monitor_get_stats(monitor, &stats);
+        Serial.printf("Packet OK:  %d sensors (ring max %u, lost %lu)\n",
+                      stats.sensor_count, (unsigned)rxRing.high_water,
+                      (unsigned long)rxRing.overflows);
     }
     
     /* Timeout */
-    if (millis() - hw_monitor.last_update > 10000) {
-        hw_monitor_invalidate_all();
+    if (hw_monitor_age_ms(monitor) > 10000) {
+        hw_monitor_invalidate_all(monitor);
     }
     
     updateDisplay();
@@ -0,0 +1,417 @@
+/**
+ * @file parser_bench.cpp
+ * @brief Benchmark parsera HWMonitor: processByte() vs feed()
+ *
+ * Buduje w RAM strumień ramek v2 i mierzy przepustowość (bajty/s)
+ * dla obu ścieżek, sam koszt CRC16 na bajt oraz czas get() po ID.
+ * Ten sam strumień w ramkowaniu COBS: narzut bajtów, przepustowość
+ * i ile danych ginie po jednym przekłamanym bajcie na ramkę.
+ * Te same wartości jako ramki SCHEMA + VALUES (bez ID przy sensorach).
+ * Te same wartości w protokole tekstowym ($S / ID:VALUE / $E:XX).
+ * Ścieżka przez HWRing: zapis jak z callbacku odbioru, drain() porcjami.
+ * Wyniki na Serial.
+ */
+
+#include <Arduino.h>
+#include "HWMonitor.h"
+
+#define BENCH_SENSORS     100
+#define BENCH_FRAMES      16
+#define BENCH_ITERATIONS  20
+#define BENCH_CHUNK       64
+
+#define FRAME_SIZE(n)     (3 + (n) * HW_RECORD_SIZE_V2 + 3)
+#define COBS_SIZE(n)      (FRAME_SIZE(n) + FRAME_SIZE(n) / 254 + 2)
+#define SCHEMA_SIZE(n)    (HW_HEADER_SIZE_V3 + (n) * HW_RECORD_SIZE_ID + 3)
+#define VALUES_SIZE(n)    (HW_HEADER_SIZE_VALUES + (n) * 4 + 3)
+#define TEXT_SIZE(n)      (4 + (n) * 16 + 7)
+
+HWMonitor monitor;
+HWRing<1024> ring;
+
+static uint8_t stream[BENCH_FRAMES * FRAME_SIZE(BENCH_SENSORS)];
+static size_t streamLen = 0;
+
+/* Te same ramki po COBS, każda zakończona 0x00 */
+static uint8_t cobsStream[BENCH_FRAMES * COBS_SIZE(BENCH_SENSORS)];
+static size_t cobsLen = 0;
+
+/* Jedna ramka SCHEMA, potem same wartości */
+static uint8_t valuesStream[SCHEMA_SIZE(BENCH_SENSORS) + BENCH_FRAMES * VALUES_SIZE(BENCH_SENSORS)];
+static size_t valuesLen = 0;
+static uint16_t schemaHash = 0;
+
+/* Te same ramki tekstem, tak jak wysyła BuildTextPacketV2() */
+static char textStream[BENCH_FRAMES * TEXT_SIZE(BENCH_SENSORS)];
+static size_t textLen = 0;
+
+static void appendSchema(uint8_t sensors)
+{
+    uint8_t* pkt = valuesStream + valuesLen;
+    size_t idx = 0;
+
+    pkt[idx++] = HW_PROTO_START;
+    pkt[idx++] = HW_PROTO_VERSION_V3;
+    pkt[idx++] = HW_FRAME_SCHEMA;
+    pkt[idx++] = 0;
+    pkt[idx++] = sensors;
+
+    for (uint8_t i = 0; i < sensors; i++) {
+        uint16_t id = 0x0100 + i;
+        pkt[idx++] = id >> 8;
+        pkt[idx++] = id & 0xFF;
+    }
+    schemaHash = hwCrc16(pkt + HW_HEADER_SIZE_V3, idx - HW_HEADER_SIZE_V3);
+
+    uint16_t crc = hwCrc16(pkt + 1, idx - 1);
+    pkt[idx++] = crc & 0xFF;
+    pkt[idx++] = crc >> 8;
+    pkt[idx++] = HW_PROTO_END;
+
+    valuesLen += idx;
+}
+
+static void appendValues(uint8_t sensors, float base, uint8_t seq)
+{
+    uint8_t* pkt = valuesStream + valuesLen;
+    size_t idx = 0;
+
+    pkt[idx++] = HW_PROTO_START;
+    pkt[idx++] = HW_PROTO_VERSION_V3;
+    pkt[idx++] = HW_FRAME_VALUES | HW_ENC_FLOAT32;
+    pkt[idx++] = seq;
+    pkt[idx++] = schemaHash & 0xFF;
+    pkt[idx++] = schemaHash >> 8;
+    pkt[idx++] = sensors;
+
+    for (uint8_t i = 0; i < sensors; i++) {
+        float value = base + i * 0.1f;
+        memcpy(pkt + idx, &value, 4);
+        idx += 4;
+    }
+
+    uint16_t crc = hwCrc16(pkt + 1, idx - 1);
+    pkt[idx++] = crc & 0xFF;
+    pkt[idx++] = crc >> 8;
+    pkt[idx++] = HW_PROTO_END;
+
+    valuesLen += idx;
+}
+
+static void appendText(uint8_t sensors, int frame)
+{
+    char* pkt = textStream + textLen;
+    size_t idx = 0;
+
+    idx += sprintf(pkt + idx, "$S\r\n");
+
+    /* Wartość jak w appendFrame(), "F1" liczone na całkowitych */
+    for (uint8_t i = 0; i < sensors; i++) {
+        unsigned tenths = frame * 10 + i;
+        idx += sprintf(pkt + idx, "%04X:%u.%u\r\n", 0x0100 + i, tenths / 10, tenths % 10);
+    }
+
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < idx; i++) {
+        checksum ^= (uint8_t)pkt[i];
+    }
+    idx += sprintf(pkt + idx, "$E:%02X\r\n", checksum);
+
+    textLen += idx;
+}
+
+/* Ramka v2 z N sensorami, dopisywana na koniec bufora */
+static void appendFrame(uint8_t sensors, float base)
+{
+    uint8_t* pkt = stream + streamLen;
+    size_t idx = 0;
+
+    pkt[idx++] = HW_PROTO_START;
+    pkt[idx++] = HW_PROTO_VERSION_V2;
+    pkt[idx++] = sensors;
+
+    for (uint8_t i = 0; i < sensors; i++) {
+        uint16_t id = 0x0100 + i;
+        float value = base + i * 0.1f;
+
+        pkt[idx++] = id >> 8;
+        pkt[idx++] = id & 0xFF;
+        memcpy(pkt + idx, &value, 4);
+        idx += 4;
+    }
+
+    uint16_t crc = hwCrc16(pkt + 1, idx - 1);
+    pkt[idx++] = crc & 0xFF;
+    pkt[idx++] = crc >> 8;
+    pkt[idx++] = HW_PROTO_END;
+
+    streamLen += idx;
+
+    cobsLen += hwCobsEncode(pkt, idx, cobsStream + cobsLen);
+    cobsStream[cobsLen++] = HW_COBS_DELIMITER;
+}
+
+static void report(const char* name, uint32_t us, uint32_t packets, size_t len = streamLen)
+{
+    float bytes = (float)len * BENCH_ITERATIONS;
+    float bps = us ? bytes * 1000000.0f / us : 0;
+
+    Serial.printf("%-14s %8lu us  %10.0f B/s  %6.1f ns/B  packets=%lu\n",
+                  name, (unsigned long)us, bps,
+                  bytes ? us * 1000.0f / bytes : 0, (unsigned long)packets);
+}
+
+static void benchProcessByte()
+{
+    monitor.reset();
+    uint32_t t0 = micros();
+
+    for (int it = 0; it < BENCH_ITERATIONS; it++) {
+        for (size_t i = 0; i < streamLen; i++) {
+            monitor.processByte(stream[i]);
+        }
+    }
+
+    report("processByte", micros() - t0, monitor.packetsOK);
+}
+
+static void benchFeed()
+{
+    monitor.reset();
+    uint32_t t0 = micros();
+
+    /* Kawałki jak z update(): readBytes() po BENCH_CHUNK bajtów */
+    for (int it = 0; it < BENCH_ITERATIONS; it++) {
+        for (size_t off = 0; off < streamLen; off += BENCH_CHUNK) {
+            size_t n = streamLen - off < BENCH_CHUNK ? streamLen - off : BENCH_CHUNK;
+            monitor.feed(stream + off, n);
+        }
+    }
+
+    report("feed", micros() - t0, monitor.packetsOK);
+}
+
+static void benchRing()
+{
+    monitor.reset();
+    uint32_t t0 = micros();
+
+    /* Callback odbioru dokłada po BENCH_CHUNK, pętla parsuje porcjami
+       gdy w ringu zabraknie miejsca - koszt ringu ponad samo feed() */
+    for (int it = 0; it < BENCH_ITERATIONS; it++) {
+        for (size_t off = 0; off < streamLen; off += BENCH_CHUNK) {
+            size_t n = streamLen - off < BENCH_CHUNK ? streamLen - off : BENCH_CHUNK;
+            while (hw_ring_size(&ring) - ring.available() < n) {
+                monitor.drain(ring);
+            }
+            ring.write(stream + off, n);
+        }
+    }
+    while (ring.available()) {
+        monitor.drain(ring);
+    }
+
+    report("ring drain", micros() - t0, monitor.packetsOK);
+    Serial.printf("%-14s max %u/%u B  lost %lu B\n", "ring",
+                  (unsigned)ring.highWater(), (unsigned)hw_ring_size(&ring),
+                  (unsigned long)ring.overflowed());
+}
+
+static void benchFeedCobs()
+{
+    monitor.reset();
+    monitor.setFraming(HW_FRAMING_COBS);
+    uint32_t t0 = micros();
+
+    for (int it = 0; it < BENCH_ITERATIONS; it++) {
+        for (size_t off = 0; off < cobsLen; off += BENCH_CHUNK) {
+            size_t n = cobsLen - off < BENCH_CHUNK ? cobsLen - off : BENCH_CHUNK;
+            monitor.feed(cobsStream + off, n);
+        }
+    }
+
+    report("feed COBS", micros() - t0, monitor.packetsOK, cobsLen);
+    monitor.setFraming(HW_FRAMING_RAW);
+}
+
+static void benchText()
+{
+    const uint8_t* text = (const uint8_t*)textStream;
+
+    monitor.reset();
+    monitor.setFraming(HW_FRAMING_TEXT);
+    uint32_t t0 = micros();
+
+    for (int it = 0; it < BENCH_ITERATIONS; it++) {
+        for (size_t off = 0; off < textLen; off += BENCH_CHUNK) {
+            size_t n = textLen - off < BENCH_CHUNK ? textLen - off : BENCH_CHUNK;
+            monitor.feed(text + off, n);
+        }
+    }
+
+    report("feed TEXT", micros() - t0, monitor.packetsOK, textLen);
+
+    monitor.reset();
+    t0 = micros();
+
+    for (int it = 0; it < BENCH_ITERATIONS; it++) {
+        for (size_t i = 0; i < textLen; i++) {
+            monitor.processByte(text[i]);
+        }
+    }
+
+    report("processByte TEXT", micros() - t0, monitor.packetsOK, textLen);
+    monitor.setFraming(HW_FRAMING_RAW);
+}
+
+static void benchFeedValues()
+{
+    monitor.reset();
+    uint32_t t0 = micros();
+
+    /* Schemat zostaje w pamięci, kolejne iteracje to same ramki VALUES */
+    for (int it = 0; it < BENCH_ITERATIONS; it++) {
+        for (size_t off = 0; off < valuesLen; off += BENCH_CHUNK) {
+            size_t n = valuesLen - off < BENCH_CHUNK ? valuesLen - off : BENCH_CHUNK;
+            monitor.feed(valuesStream + off, n);
+        }
+    }
+
+    report("feed VALUES", micros() - t0, monitor.packetsOK, valuesLen);
+}
+
+/* Jeden przekłamany bajt w co drugiej ramce, w tym samym miejscu dla
+   obu ramkowań. Czyste ramki obok uszkodzonych powinny przejść; liczy
+   ramki, które przeszły, i bajty odrzucone po błędzie. */
+static size_t noisePos(size_t len, int f)
+{
+    size_t step = len / BENCH_FRAMES;
+    return f * step + 7 + (f * 37) % (step - 7);
+}
+
+static void benchNoise(const char* name, HWFraming framing, uint8_t* buf, size_t len)
+{
+    uint8_t saved[BENCH_FRAMES];
+
+    for (int f = 0; f < BENCH_FRAMES; f += 2) {
+        saved[f] = buf[noisePos(len, f)];
+        buf[noisePos(len, f)] ^= 0x5A;
+    }
+
+    monitor.reset();
+    monitor.setFraming(framing);
+    for (size_t off = 0; off < len; off += BENCH_CHUNK) {
+        size_t n = len - off < BENCH_CHUNK ? len - off : BENCH_CHUNK;
+        monitor.feed(buf + off, n);
+    }
+    monitor.setFraming(HW_FRAMING_RAW);
+
+    for (int f = 0; f < BENCH_FRAMES; f += 2) {
+        buf[noisePos(len, f)] = saved[f];
+    }
+
+    Serial.printf("%-14s ok=%lu/%d  errors=%lu  resyncs=%lu  maxBytes=%lu\n",
+                  name, (unsigned long)monitor.packetsOK, BENCH_FRAMES,
+                  (unsigned long)monitor.packetsError,
+                  (unsigned long)monitor.resync.events,
+                  (unsigned long)monitor.resync.maxBytes);
+}
+
+static void benchCrc()
+{
+    volatile uint16_t sink = 0;
+    uint32_t t0 = micros();
+
+    for (int it = 0; it < BENCH_ITERATIONS; it++) {
+        sink = hwCrc16(stream, streamLen, sink);
+    }
+
+    report("crc16", micros() - t0, 0);
+}
+
+static void benchCobsEncode()
+{
+    static uint8_t out[COBS_SIZE(BENCH_SENSORS)];
+    size_t frameLen = FRAME_SIZE(BENCH_SENSORS);
+    uint32_t t0 = micros();
+
+    /* Koszt po stronie nadawcy: kodowanie ramka po ramce */
+    for (int it = 0; it < BENCH_ITERATIONS; it++) {
+        for (size_t off = 0; off < streamLen; off += frameLen) {
+            hwCobsEncode(stream + off, frameLen, out);
+        }
+    }
+
+    report("cobs encode", micros() - t0, 0);
+}
+
+static void benchLookup()
+{
+    volatile float sink = 0;
+    uint32_t lookups = 0;
+    uint32_t t0 = micros();
+
+    /* Wszystkie ID z ramki + tyle samo nieistniejących */
+    for (int it = 0; it < BENCH_ITERATIONS; it++) {
+        for (uint16_t i = 0; i < 2 * BENCH_SENSORS; i++) {
+            sink = sink + monitor.get(0x0100 + i);
+            lookups++;
+        }
+    }
+
+    uint32_t us = micros() - t0;
+    Serial.printf("%-14s %8lu us  %10lu lookups  %6.1f ns/lookup\n",
+                  "get", (unsigned long)us, (unsigned long)lookups,
+                  lookups ? us * 1000.0f / lookups : 0);
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    delay(2000);
+
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        appendFrame(BENCH_SENSORS, f * 1.0f);
+    }
+
+    appendSchema(BENCH_SENSORS);
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        appendValues(BENCH_SENSORS, f * 1.0f, f + 1);
+    }
+
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        appendText(BENCH_SENSORS, f);
+    }
+
+    monitor.begin();
+
+    Serial.println();
+    Serial.println("=== HWMonitor parser benchmark ===");
+    Serial.printf("Stream: %u bytes (%d frames x %d sensors), %d iterations\n",
+                  (unsigned)streamLen, BENCH_FRAMES, BENCH_SENSORS, BENCH_ITERATIONS);
+    Serial.printf("COBS:   %u bytes (+%.2f%%)\n",
+                  (unsigned)cobsLen, (cobsLen - streamLen) * 100.0f / streamLen);
+    Serial.printf("VALUES: %u bytes (%.2f%%, schema included)\n",
+                  (unsigned)valuesLen, ((float)valuesLen - streamLen) * 100.0f / streamLen);
+    Serial.printf("TEXT:   %u bytes (%+.2f%%)\n",
+                  (unsigned)textLen, ((float)textLen - streamLen) * 100.0f / streamLen);
+}
+
+void loop()
+{
+    benchProcessByte();
+    benchFeed();
+    benchRing();
+    benchFeedCobs();
+    benchFeedValues();
+    benchText();
+    benchCrc();
+    benchCobsEncode();
+    benchLookup();
+    benchNoise("noise raw", HW_FRAMING_RAW, stream, streamLen);
+    benchNoise("noise COBS", HW_FRAMING_COBS, cobsStream, cobsLen);
+    benchNoise("noise TEXT", HW_FRAMING_TEXT, (uint8_t*)textStream, textLen);
+    Serial.println();
+
+    delay(5000);
+}
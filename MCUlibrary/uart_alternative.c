@@ -4,6 +4,7 @@
  */
 
 #include "driver/uart.h"
+#include "hw_monitor.h"
 
 #define DATA_UART       UART_NUM_1
 #define DATA_TX_PIN     GPIO_NUM_17
@@ -27,14 +28,17 @@ static void uart_data_init(void)
 
 static void uart_rx_task(void* arg)
 {
+    hw_monitor_t* monitor = hw_monitor_init(1);  /* Port 1, niezależny od USB */
     uint8_t buf[512];
     
     while (1) {
         int len = uart_read_bytes(DATA_UART, buf, sizeof(buf), pdMS_TO_TICKS(100));
         
         if (len > 0) {
-            if (hw_monitor_parse(buf, len)) {
-                printf("Data received: %d sensors\n", hw_monitor.sensor_count);
+            if (hw_monitor_parse(monitor, buf, len)) {
+                hw_monitor_stats_t stats;
+                hw_monitor_get_stats(monitor, &stats);
+                printf("Data received: %d sensors\n", stats.sensor_count);
             }
         }
     }
@@ -15,6 +15,12 @@ namespace HardwareMonitorTray
         public int SendIntervalMs { get; set; } = 500;
         public int RefreshIntervalMs { get; set; } = 250;  // NOWE - odświeżanie danych z hardware
         public ProtocolMode ProtocolMode { get; set; } = ProtocolMode.Binary;
+        public int KeyframeInterval { get; set; } = 0;  // 0 = pełne ramki v2, N = ramki delta v3 z pełną ramką co N
+        public ValueEncoding ValueEncoding { get; set; } = ValueEncoding.Float32;  // tylko ramki v3
+        public Framing Framing { get; set; } = Framing.Raw;  // Cobs = ramki COBS z separatorem 0x00
+        public bool SchemaFrames { get; set; } = false;  // keyframe'y v3 bez ID (ramki SCHEMA + VALUES)
+        public bool FlowControl { get; set; } = true;  // kredyty ACK/NACK z MCU, gdy firmware je wysyła
+        public bool MetadataFrames { get; set; } = true;  // nazwy/jednostki/role sensorów dla MCU (v3)
         public IconStyle IconStyle { get; set; } = IconStyle.Modern;
         public bool AutoStart { get; set; } = false;
         public bool StartWithWindows { get; set; } = false;
@@ -12,8 +12,96 @@ namespace HardwareMonitorTray
 
         public ProtocolMode Mode { get; set; } = ProtocolMode.Binary;
 
+        /// <summary>
+        /// Co ile ramek wysyłana jest pełna ramka (keyframe).
+        /// 0 = zawsze pełne ramki v2 (zgodność ze starszym firmware).
+        /// </summary>
+        public int KeyframeInterval { get; set; } = 0;
+
+        /// <summary>
+        /// Kodowanie wartości w ramkach v3 (float32 / float16 / int16 ze skalą)
+        /// </summary>
+        public ValueEncoding Encoding { get; set; } = ValueEncoding.Float32;
+
+        /// <summary>
+        /// Ramkowanie binarne - Cobs wymaga monitor.setFraming(HW_FRAMING_COBS) na MCU
+        /// </summary>
+        public Framing Framing { get; set; } = Framing.Raw;
+
+        /// <summary>
+        /// Keyframe'y v3 jako ramki VALUES - same wartości w kolejności z ramki SCHEMA,
+        /// bez 2-bajtowego ID przy każdym sensorze
+        /// </summary>
+        public bool SchemaFrames { get; set; } = false;
+
+        /// <summary>
+        /// Kredyty od MCU (ACK/NACK, monitor.enableFlowControl()). Działa dopiero po
+        /// pierwszym ACK, więc firmware bez sterowania przepływem dostaje dane jak dawniej.
+        /// </summary>
+        public bool FlowControl { get; set; } = true;
+
+        /// <summary>
+        /// Ramki META z nazwą, jednostką i rolą sensorów (v3). Wysyłane tylko gdy zmieni się
+        /// mapa/lista sensorów albo MCU zgłosi w ACK, że ich nie ma (restart).
+        /// </summary>
+        public bool MetadataFrames { get; set; } = true;
+
         public int PacketsSent { get; private set; }
         public int PacketsErrors { get; private set; }
+        public long BytesSent { get; private set; }
+        public int FramesDeferred { get; private set; }  // ticki pominięte z braku kredytów
+        public int NacksReceived { get; private set; }
+
+        /// <summary>
+        /// Liczba sensorów zamówionych przez MCU (monitor.subscribe()), 0 = wysyłamy wszystkie
+        /// </summary>
+        public int SubscribedCount
+        {
+            get { lock (_flowLock) return _subscription?.Count ?? 0; }
+        }
+
+        // Stan ramek delta - ostatnio wysłane wartości i numer sekwencji
+        private readonly Dictionary<ushort, float> _lastSent = new();
+        private byte _frameSeq;
+        private int _framesSinceKeyframe;
+
+        // Skale int16 per sensor - tylko rosną, żeby MCU rzadko dostawał nowe ramki SCALE
+        private static readonly float[] Scales = { 0.1f, 1f, 10f, 100f, 1000f };
+        private const int ScaleRefreshKeyframes = 10;  // pełna tabela skal co N keyframe'ów (restart MCU)
+        private readonly Dictionary<ushort, float> _scales = new();
+        private int _keyframesSinceScales;
+
+        // Ostatnio wysłany schemat - nowy idzie przy zmianie listy sensorów i co N keyframe'ów
+        private const int SchemaRefreshKeyframes = 10;
+        private readonly List<ushort> _schemaIds = new();
+        private ushort _schemaHash;
+        private int _keyframesSinceSchema;
+
+        // Pierwsza ramka COBS po Connect dostaje separator z przodu
+        private bool _streamStart;
+
+        // Sterowanie przepływem - stan z ramek ACK/NACK (wątek DataReceived)
+        private const int FlowProbeMs = 1000;     // bez ACK: jedna ramka próbna co tyle ms
+        private const int FlowFallbackMs = 5000;  // bez ACK: powrót do wysyłania bez limitu
+        private const int MaxRxBuffer = 1024;  // mieści najdłuższą ramkę SUBSCRIBE (255 ID)
+        private readonly object _flowLock = new();
+        private readonly List<byte> _rxBuffer = new();
+        private bool _flowActive;
+        private byte _ackedSeq;
+        private int _credit;
+        private long _lastAckTicks;
+        private long _lastProbeTicks;
+        private byte _keyframeSeq;
+        private bool _keyframeRequested;
+
+        // Zbiór ID z ramki SUBSCRIBE, null = MCU nic nie zgłosił
+        private HashSet<ushort> _subscription;
+
+        // Ostatnio wysłane metadane (CRC rekordów) i SEQ ich ostatniej ramki
+        private ushort _metaHash;
+        private bool _metaSent;
+        private byte _metaSeq;
+        private bool _metaRequested;
 
         public static string[] GetAvailablePorts()
         {
@@ -36,12 +124,28 @@ namespace HardwareMonitorTray
                 ReadBufferSize = 4096
             };
 
+            _serialPort.DataReceived += OnDataReceived;
             _serialPort.Open();
             _serialPort.DiscardInBuffer();
             _serialPort.DiscardOutBuffer();
 
             PacketsSent = 0;
             PacketsErrors = 0;
+            BytesSent = 0;
+            FramesDeferred = 0;
+            NacksReceived = 0;
+            RequestKeyframe();
+            _streamStart = true;
+
+            lock (_flowLock)
+            {
+                _rxBuffer.Clear();
+                _flowActive = false;
+                _keyframeRequested = false;
+                _subscription = null;
+                _metaSent = false;
+                _metaRequested = false;
+            }
 
             System.Diagnostics.Debug.WriteLine($"[Serial] Connected to {portName} @ {baudRate} (Protocol v2)");
         }
@@ -65,6 +169,10 @@ namespace HardwareMonitorTray
             if (_serialPort == null || !_serialPort.IsOpen || sensors.Count == 0)
                 return;
 
+            sensors = FilterSubscribed(sensors);
+            if (sensors.Count == 0)
+                return;
+
             try
             {
                 byte[] packet;
@@ -72,12 +180,22 @@ namespace HardwareMonitorTray
                 switch (Mode)
                 {
                     case ProtocolMode.Binary:
-                        packet = BuildBinaryPacketV2(sensors);
+                        // Brak kredytów - nic nie budujemy, delta z następnego ticka obejmie zmiany
+                        if (KeyframeInterval > 0 && !AcquireCredit())
+                        {
+                            FramesDeferred++;
+                            return;
+                        }
+
+                        packet = KeyframeInterval > 0
+                            ? BuildBinaryPacketV3(sensors)
+                            : FrameBytes(BuildBinaryPacketV2(sensors));
                         break;
                     case ProtocolMode.Text:
                         var text = BuildTextPacketV2(sensors);
                         _serialPort.Write(text);
                         PacketsSent++;
+                        BytesSent += text.Length;
                         return;
                     case ProtocolMode.Json:
                         return;
@@ -92,10 +210,19 @@ namespace HardwareMonitorTray
                     return;
                 }
 
-                System.Diagnostics.Debug.WriteLine($"[Serial] Sending {packet.Length} bytes ({sensors.Count} sensors, Protocol v2)");
+                System.Diagnostics.Debug.WriteLine($"[Serial] Sending {packet.Length} bytes ({sensors.Count} sensors, {(KeyframeInterval > 0 ? "Protocol v3" : "Protocol v2")}, {Framing})");
+
+                // Separator na start - MCU odrzuci śmieci sprzed połączenia, a nie pierwszą ramkę
+                if (_streamStart && Framing == Framing.Cobs)
+                {
+                    _serialPort.Write(new[] { SerialProtocol.COBS_DELIMITER }, 0, 1);
+                    BytesSent++;
+                }
+                _streamStart = false;
 
                 _serialPort.Write(packet, 0, packet.Length);
                 PacketsSent++;
+                BytesSent += packet.Length;
             }
             catch (Exception ex)
             {
@@ -142,8 +269,8 @@ namespace HardwareMonitorTray
                 packet[idx++] = valueBytes[3];
             }
 
-            // CRC16 (from VER to last data byte)
-            ushort crc = CalculateCRC16(packet, 1, 2 + count * 6);
+            // CRC16/MODBUS (from VER to last data byte)
+            ushort crc = SerialProtocol.CalculateCRC16(packet, 1, 2 + count * 6);
             packet[idx++] = (byte)(crc & 0xFF);
             packet[idx++] = (byte)(crc >> 8);
 
@@ -153,6 +280,589 @@ namespace HardwareMonitorTray
             return packet;
         }
 
+        /// <summary>
+        /// Wymusza pełną ramkę przy następnym wysłaniu
+        /// </summary>
+        public void RequestKeyframe()
+        {
+            _lastSent.Clear();
+            _scales.Clear();
+            _schemaIds.Clear();
+            _framesSinceKeyframe = 0;
+        }
+
+        /// <summary>
+        /// Buduje pakiet binarny Protocol v3 - pełna ramka co KeyframeInterval ramek,
+        /// pomiędzy nimi tylko sensory, których wartość się zmieniła.
+        /// Struktura: [START 0xAA][VER 0x03][TYPE][SEQ][COUNT][ID_HI][ID_LO][VALUE]...[CRC16][END 0x55]
+        /// W trybie Scaled przed ramką danych idą ramki SCALE dla nowych/zmienionych skal.
+        /// Z SchemaFrames keyframe to ramka VALUES: [..][SEQ][HASH lo][HASH hi][COUNT][VALUE]...
+        /// </summary>
+        private byte[] BuildBinaryPacketV3(List<CompactSensorData> sensors)
+        {
+            bool keyframe = _lastSent.Count == 0 || _framesSinceKeyframe >= KeyframeInterval;
+            bool scaled = Encoding == ValueEncoding.Scaled;
+            bool refreshScales = false;
+
+            if (scaled && keyframe)
+            {
+                refreshScales = _scales.Count == 0 || ++_keyframesSinceScales >= ScaleRefreshKeyframes;
+                if (refreshScales)
+                    _keyframesSinceScales = 0;
+            }
+
+            var records = new List<CompactSensorData>(sensors.Count);
+            var scaleChanges = new List<ushort>();
+
+            foreach (var sensor in sensors)
+            {
+                if (records.Count >= SerialProtocol.MAX_SENSORS)
+                    break;
+
+                ushort id = (ushort)sensor.Id;
+
+                if (scaled)
+                {
+                    // int16 nie przeniesie NaN/Inf
+                    if (float.IsNaN(sensor.Value) || float.IsInfinity(sensor.Value))
+                        continue;
+
+                    if (UpdateScale(id, sensor.Value) || refreshScales)
+                        scaleChanges.Add(id);
+                }
+
+                // Porównanie po kwantyzacji - NaN też jest "bez zmian"
+                if (!keyframe && !scaleChanges.Contains(id) &&
+                    _lastSent.TryGetValue(id, out float last) && last.Equals(Quantize(id, sensor.Value)))
+                    continue;
+
+                records.Add(sensor);
+            }
+
+            if (keyframe)
+            {
+                _lastSent.Clear();
+                _framesSinceKeyframe = 0;
+            }
+
+            foreach (var sensor in records)
+            {
+                _lastSent[(ushort)sensor.Id] = Quantize((ushort)sensor.Id, sensor.Value);
+            }
+
+            _framesSinceKeyframe++;
+
+            var output = new List<byte>();
+
+            // Metadane przed danymi - MCU od razu wie, które ID jest np. temperaturą CPU
+            if (keyframe && MetadataFrames)
+                output.AddRange(BuildMetaFrames(records));
+
+            // Skale muszą dotrzeć przed wartościami, które z nich korzystają
+            for (int i = 0; i < scaleChanges.Count; i += SerialProtocol.SCALE_RECORDS)
+            {
+                output.AddRange(FrameBytes(BuildScaleFrame(scaleChanges.GetRange(i, Math.Min(SerialProtocol.SCALE_RECORDS, scaleChanges.Count - i)))));
+            }
+
+            // Keyframe bez ID - MCU musi mieć aktualny schemat
+            bool positional = keyframe && SchemaFrames;
+            if (positional)
+            {
+                var ids = records.ConvertAll(s => (ushort)s.Id);
+                if (!ids.SequenceEqual(_schemaIds) || ++_keyframesSinceSchema >= SchemaRefreshKeyframes)
+                {
+                    output.AddRange(FrameBytes(BuildSchemaFrame(ids)));
+                    _schemaIds.Clear();
+                    _schemaIds.AddRange(ids);
+                    _keyframesSinceSchema = 0;
+                }
+            }
+
+            byte encoding = Encoding switch
+            {
+                ValueEncoding.Float16 => SerialProtocol.ENC_FLOAT16,
+                ValueEncoding.Scaled => SerialProtocol.ENC_INT16,
+                _ => SerialProtocol.ENC_FLOAT32
+            };
+            int recordSize = Encoding == ValueEncoding.Float32 ? SerialProtocol.SENSOR_SIZE : SerialProtocol.SENSOR_SIZE_16;
+            if (positional)
+                recordSize -= SerialProtocol.ID_SIZE;
+
+            int count = records.Count;
+            int headerSize = positional ? SerialProtocol.HEADER_SIZE_VALUES : SerialProtocol.HEADER_SIZE_V3;
+            int packetSize = headerSize + (count * recordSize) + SerialProtocol.FOOTER_SIZE;
+            byte[] packet = new byte[packetSize];
+
+            int idx = 0;
+
+            // Header
+            packet[idx++] = SerialProtocol.START_BYTE;
+            packet[idx++] = SerialProtocol.PROTOCOL_VERSION_DELTA;
+            byte kind = positional ? SerialProtocol.FRAME_VALUES : keyframe ? SerialProtocol.FRAME_KEYFRAME : SerialProtocol.FRAME_DELTA;
+            packet[idx++] = (byte)(kind | encoding);
+            if (keyframe)
+            {
+                lock (_flowLock)
+                    _keyframeSeq = _frameSeq;
+            }
+            packet[idx++] = _frameSeq++;
+            if (positional)
+            {
+                packet[idx++] = (byte)(_schemaHash & 0xFF);
+                packet[idx++] = (byte)(_schemaHash >> 8);
+            }
+            packet[idx++] = (byte)count;
+
+            foreach (var sensor in records)
+            {
+                ushort id = (ushort)sensor.Id;
+                if (!positional)
+                {
+                    packet[idx++] = (byte)(id >> 8);
+                    packet[idx++] = (byte)(id & 0xFF);
+                }
+                WriteValue(packet, ref idx, id, sensor.Value);
+            }
+
+            // CRC16/MODBUS (od VER do ostatniego bajtu danych)
+            ushort crc = SerialProtocol.CalculateCRC16(packet, 1, idx - 1);
+            packet[idx++] = (byte)(crc & 0xFF);
+            packet[idx++] = (byte)(crc >> 8);
+
+            packet[idx++] = SerialProtocol.END_BYTE;
+
+            packet = FrameBytes(packet);
+            if (output.Count == 0)
+                return packet;
+
+            output.AddRange(packet);
+            return output.ToArray();
+        }
+
+        /// <summary>
+        /// Czy można wysłać kolejną ramkę v3. Bez ACK od MCU zawsze tak (stary firmware).
+        /// NACK z MCU zamienia następną ramkę w keyframe.
+        /// </summary>
+        private bool AcquireCredit()
+        {
+            bool keyframe;
+            lock (_flowLock)
+            {
+                keyframe = _keyframeRequested;
+                _keyframeRequested = false;
+            }
+
+            if (keyframe)
+                RequestKeyframe();
+
+            lock (_flowLock)
+            {
+                if (!FlowControl || !_flowActive)
+                    return true;
+
+                long now = Environment.TickCount64;
+                if (now - _lastAckTicks > FlowFallbackMs)
+                {
+                    // MCU przestał odpowiadać (restart, inny firmware) - wysyłamy jak dawniej
+                    _flowActive = false;
+                    return true;
+                }
+
+                // Ramki wysłane po ostatniej potwierdzonej
+                int inFlight = (byte)(_frameSeq - 1 - _ackedSeq);
+                if (inFlight < _credit)
+                    return true;
+
+                // Zgubiony ACK nie może zablokować wysyłania na stałe
+                if (now - _lastAckTicks > FlowProbeMs && now - _lastProbeTicks > FlowProbeMs)
+                {
+                    _lastProbeTicks = now;
+                    return true;
+                }
+
+                return false;
+            }
+        }
+
+        private void OnDataReceived(object sender, SerialDataReceivedEventArgs e)
+        {
+            try
+            {
+                var port = (SerialPort)sender;
+                int available = port.BytesToRead;
+                if (available <= 0)
+                    return;
+
+                byte[] data = new byte[available];
+                int read = port.Read(data, 0, available);
+
+                lock (_flowLock)
+                {
+                    for (int i = 0; i < read; i++)
+                        _rxBuffer.Add(data[i]);
+
+                    ParseControlFrames();
+                }
+            }
+            catch (Exception ex)
+            {
+                System.Diagnostics.Debug.WriteLine($"[Serial] Read error: {ex.Message}");
+            }
+        }
+
+        /// <summary>
+        /// Tylko sensory zamówione przez MCU, kolejność bez zmian
+        /// </summary>
+        private List<CompactSensorData> FilterSubscribed(List<CompactSensorData> sensors)
+        {
+            HashSet<ushort> subscription;
+            lock (_flowLock)
+                subscription = _subscription;
+
+            if (subscription == null)
+                return sensors;
+
+            return sensors.Where(s => subscription.Contains((ushort)s.Id)).ToList();
+        }
+
+        /// <summary>
+        /// Wyciąga ramki zwrotne (ACK/NACK, SUBSCRIBE) z odebranych bajtów; resztę (np. debug z MCU) pomija
+        /// </summary>
+        private void ParseControlFrames()
+        {
+            byte[] buffer = _rxBuffer.ToArray();
+            int pos = 0;
+
+            if (Framing == Framing.Cobs)
+            {
+                int delim;
+                while ((delim = Array.IndexOf(buffer, SerialProtocol.COBS_DELIMITER, pos)) >= 0)
+                {
+                    byte[] frame = SerialProtocol.CobsDecode(buffer, pos, delim - pos);
+                    if (frame != null && SerialProtocol.ControlFrameLength(frame, 0, frame.Length) == frame.Length)
+                        ApplyFrame(frame, 0);
+                    pos = delim + 1;
+                }
+            }
+            else
+            {
+                while (true)
+                {
+                    int start = Array.IndexOf(buffer, SerialProtocol.START_BYTE, pos);
+                    if (start < 0)
+                    {
+                        pos = buffer.Length;
+                        break;
+                    }
+
+                    int length = SerialProtocol.ControlFrameLength(buffer, start, buffer.Length - start);
+                    if (length == 0 || length > buffer.Length - start)
+                    {
+                        pos = start;
+                        break;
+                    }
+
+                    pos = length > 0 && ApplyFrame(buffer, start) ? start + length : start + 1;
+                }
+            }
+
+            _rxBuffer.RemoveRange(0, pos);
+            if (_rxBuffer.Count > MaxRxBuffer)
+                _rxBuffer.Clear();
+        }
+
+        private bool ApplyFrame(byte[] data, int offset)
+        {
+            if (data[offset + 2] == SerialProtocol.FRAME_SUBSCRIBE)
+            {
+                if (!SerialProtocol.TryParseSubscribeFrame(data, offset, out ushort[] ids))
+                    return false;
+
+                ApplySubscription(ids);
+                return true;
+            }
+
+            if (!SerialProtocol.TryParseControlFrame(data, offset, out byte kind, out byte flags, out byte seq, out byte credit))
+                return false;
+
+            ApplyControlFrame(kind, flags, seq, credit);
+            return true;
+        }
+
+        private void ApplySubscription(ushort[] ids)
+        {
+            var subscription = ids.Length > 0 ? new HashSet<ushort>(ids) : null;
+
+            // MCU powtarza listę co kilka sekund - keyframe tylko gdy faktycznie się zmieniła
+            bool changed = subscription == null
+                ? _subscription != null
+                : _subscription == null || !_subscription.SetEquals(subscription);
+
+            if (!changed)
+                return;
+
+            _subscription = subscription;
+            _keyframeRequested = true;
+            System.Diagnostics.Debug.WriteLine($"[Serial] MCU subscribed to {ids.Length} sensors");
+        }
+
+        private void ApplyControlFrame(byte kind, byte flags, byte seq, byte credit)
+        {
+            // MCU bez metadanych po ostatniej ramce META - zrestartował się
+            if ((flags & SerialProtocol.STATUS_WANT_META) != 0 && _metaSent && (sbyte)(seq - _metaSeq) >= 0)
+                _metaRequested = true;
+
+            _flowActive = FlowControl;
+            _ackedSeq = seq;
+            _credit = credit;
+            _lastAckTicks = Environment.TickCount64;
+
+            // NACK sprzed ostatniego keyframe'a - ten keyframe jest jeszcze w drodze
+            if (kind == SerialProtocol.FRAME_NACK && (sbyte)(seq - _keyframeSeq) >= 0)
+            {
+                _keyframeRequested = true;
+                NacksReceived++;
+            }
+        }
+
+        /// <summary>
+        /// Gotowa ramka w wybranym ramkowaniu - Raw bez zmian, Cobs zakodowana z separatorem
+        /// </summary>
+        private byte[] FrameBytes(byte[] packet)
+        {
+            if (packet == null || Framing != Framing.Cobs)
+                return packet;
+
+            return SerialProtocol.CobsEncode(packet);
+        }
+
+        /// <summary>
+        /// Ramki META dla wysyłanych sensorów, pusta tablica gdy MCU ma już te metadane.
+        /// Pierwsza ramka ma flagę META_RESET, po max META_RECORDS rekordów na ramkę.
+        /// </summary>
+        private byte[] BuildMetaFrames(List<CompactSensorData> sensors)
+        {
+            bool requested;
+            lock (_flowLock)
+            {
+                requested = _metaRequested;
+                _metaRequested = false;
+            }
+
+            var byId = new Dictionary<ushort, KeyValuePair<string, SensorIdMapper.SensorMapEntry>>();
+            foreach (var kv in SensorIdMapper.Instance.GetAll())
+                byId.TryAdd(kv.Value.Id, kv);
+
+            var described = new List<(ushort Id, string SensorFullId, SensorIdMapper.SensorMapEntry Entry)>();
+            foreach (var sensor in sensors)
+            {
+                if (byId.TryGetValue((ushort)sensor.Id, out var kv))
+                    described.Add(((ushort)sensor.Id, kv.Key, kv.Value));
+            }
+
+            if (described.Count == 0)
+                return Array.Empty<byte>();
+
+            var roles = SensorRoles.Assign(described);
+            byte[] records = new byte[described.Count * SerialProtocol.META_RECORD_SIZE];
+
+            int idx = 0;
+            foreach (var (id, _, entry) in described)
+            {
+                records[idx] = (byte)(id >> 8);
+                records[idx + 1] = (byte)(id & 0xFF);
+                records[idx + 2] = roles.TryGetValue(id, out var role) ? (byte)role : (byte)0;
+                WriteText(records, idx + 3, SerialProtocol.META_UNIT_SIZE, entry.Unit);
+                WriteText(records, idx + 3 + SerialProtocol.META_UNIT_SIZE, SerialProtocol.META_NAME_SIZE, entry.Name);
+                idx += SerialProtocol.META_RECORD_SIZE;
+            }
+
+            ushort hash = SerialProtocol.CalculateCRC16(records, 0, records.Length);
+            if (_metaSent && hash == _metaHash && !requested)
+                return Array.Empty<byte>();
+
+            var output = new List<byte>();
+            int total = described.Count;
+
+            for (int first = 0; first < total; first += SerialProtocol.META_RECORDS)
+            {
+                int count = Math.Min(SerialProtocol.META_RECORDS, total - first);
+                byte[] packet = new byte[SerialProtocol.HEADER_SIZE_V3 + count * SerialProtocol.META_RECORD_SIZE + SerialProtocol.FOOTER_SIZE];
+
+                int i = 0;
+                packet[i++] = SerialProtocol.START_BYTE;
+                packet[i++] = SerialProtocol.PROTOCOL_VERSION_DELTA;
+                packet[i++] = (byte)(SerialProtocol.FRAME_META | (first == 0 ? SerialProtocol.META_RESET : 0));
+                lock (_flowLock)
+                    _metaSeq = _frameSeq;
+                packet[i++] = _frameSeq++;
+                packet[i++] = (byte)count;
+
+                Array.Copy(records, first * SerialProtocol.META_RECORD_SIZE, packet, i, count * SerialProtocol.META_RECORD_SIZE);
+                i += count * SerialProtocol.META_RECORD_SIZE;
+
+                ushort crc = SerialProtocol.CalculateCRC16(packet, 1, i - 1);
+                packet[i++] = (byte)(crc & 0xFF);
+                packet[i++] = (byte)(crc >> 8);
+                packet[i++] = SerialProtocol.END_BYTE;
+
+                output.AddRange(FrameBytes(packet));
+            }
+
+            _metaHash = hash;
+            _metaSent = true;
+
+            System.Diagnostics.Debug.WriteLine($"[Serial] Metadata sent: {total} sensors, {roles.Count} roles");
+            return output.ToArray();
+        }
+
+        /// <summary>
+        /// UTF-8 dopełnione zerami, obcięte na granicy znaku
+        /// </summary>
+        private static void WriteText(byte[] buffer, int offset, int size, string text)
+        {
+            int len = 0;
+            foreach (var rune in (text ?? "").EnumerateRunes())
+            {
+                if (len + rune.Utf8SequenceLength > size)
+                    break;
+
+                len += rune.EncodeToUtf8(buffer.AsSpan(offset + len));
+            }
+        }
+
+        /// <summary>
+        /// Buduje ramkę SCHEMA: [ID_HI][ID_LO] na sensor, w kolejności wartości ramek VALUES.
+        /// Hash schematu = CRC16 po bajtach ID (MCU liczy go tak samo).
+        /// </summary>
+        private byte[] BuildSchemaFrame(List<ushort> ids)
+        {
+            int count = ids.Count;
+            byte[] packet = new byte[SerialProtocol.HEADER_SIZE_V3 + count * SerialProtocol.ID_SIZE + SerialProtocol.FOOTER_SIZE];
+
+            int idx = 0;
+            packet[idx++] = SerialProtocol.START_BYTE;
+            packet[idx++] = SerialProtocol.PROTOCOL_VERSION_DELTA;
+            packet[idx++] = SerialProtocol.FRAME_SCHEMA;
+            packet[idx++] = _frameSeq++;
+            packet[idx++] = (byte)count;
+
+            foreach (ushort id in ids)
+            {
+                packet[idx++] = (byte)(id >> 8);
+                packet[idx++] = (byte)(id & 0xFF);
+            }
+
+            _schemaHash = SerialProtocol.CalculateCRC16(packet, SerialProtocol.HEADER_SIZE_V3, count * SerialProtocol.ID_SIZE);
+
+            ushort crc = SerialProtocol.CalculateCRC16(packet, 1, idx - 1);
+            packet[idx++] = (byte)(crc & 0xFF);
+            packet[idx++] = (byte)(crc >> 8);
+            packet[idx++] = SerialProtocol.END_BYTE;
+
+            return packet;
+        }
+
+        /// <summary>
+        /// Buduje ramkę SCALE: [ID_HI][ID_LO][SCALE float][OFFSET float] na sensor
+        /// </summary>
+        private byte[] BuildScaleFrame(List<ushort> ids)
+        {
+            int count = ids.Count;
+            byte[] packet = new byte[SerialProtocol.HEADER_SIZE_V3 + count * SerialProtocol.SCALE_RECORD_SIZE + SerialProtocol.FOOTER_SIZE];
+
+            int idx = 0;
+            packet[idx++] = SerialProtocol.START_BYTE;
+            packet[idx++] = SerialProtocol.PROTOCOL_VERSION_DELTA;
+            packet[idx++] = SerialProtocol.FRAME_SCALE;
+            packet[idx++] = _frameSeq++;
+            packet[idx++] = (byte)count;
+
+            foreach (ushort id in ids)
+            {
+                packet[idx++] = (byte)(id >> 8);
+                packet[idx++] = (byte)(id & 0xFF);
+                BitConverter.GetBytes(_scales[id]).CopyTo(packet, idx);
+                idx += 4;
+                BitConverter.GetBytes(0f).CopyTo(packet, idx);  // offset - host zawsze wysyła 0
+                idx += 4;
+            }
+
+            ushort crc = SerialProtocol.CalculateCRC16(packet, 1, idx - 1);
+            packet[idx++] = (byte)(crc & 0xFF);
+            packet[idx++] = (byte)(crc >> 8);
+            packet[idx++] = SerialProtocol.END_BYTE;
+
+            return packet;
+        }
+
+        /// <summary>
+        /// Dobiera najmniejszą skalę, w której wartość mieści się w int16.
+        /// Zwraca true, jeśli skala sensora się zmieniła.
+        /// </summary>
+        private bool UpdateScale(ushort id, float value)
+        {
+            _scales.TryGetValue(id, out float current);
+
+            foreach (float scale in Scales)
+            {
+                if (scale < current)
+                    continue;
+
+                if (Math.Abs(value / scale) <= short.MaxValue || scale == Scales[^1])
+                {
+                    _scales[id] = scale;
+                    return scale != current;
+                }
+            }
+
+            return false;
+        }
+
+        /// <summary>
+        /// Wartość, jaką MCU odczyta po dekodowaniu
+        /// </summary>
+        private float Quantize(ushort id, float value)
+        {
+            return Encoding switch
+            {
+                ValueEncoding.Float16 => (float)(Half)value,
+                ValueEncoding.Scaled => ToInt16(value, _scales[id]) * _scales[id],
+                _ => value
+            };
+        }
+
+        private static short ToInt16(float value, float scale)
+        {
+            return (short)Math.Clamp(Math.Round(value / scale), short.MinValue, short.MaxValue);
+        }
+
+        private void WriteValue(byte[] packet, ref int idx, ushort id, float value)
+        {
+            switch (Encoding)
+            {
+                case ValueEncoding.Float16:
+                    short half = BitConverter.HalfToInt16Bits((Half)value);
+                    packet[idx++] = (byte)(half & 0xFF);
+                    packet[idx++] = (byte)(half >> 8);
+                    break;
+
+                case ValueEncoding.Scaled:
+                    short raw = ToInt16(value, _scales[id]);
+                    packet[idx++] = (byte)(raw & 0xFF);
+                    packet[idx++] = (byte)(raw >> 8);
+                    break;
+
+                default:
+                    byte[] valueBytes = BitConverter.GetBytes(value);
+                    packet[idx++] = valueBytes[0];
+                    packet[idx++] = valueBytes[1];
+                    packet[idx++] = valueBytes[2];
+                    packet[idx++] = valueBytes[3];
+                    break;
+            }
+        }
+
         /// <summary>
         /// Buduje pakiet tekstowy Protocol v2 - 4-cyfrowe ID hex
         /// </summary>
@@ -164,7 +874,8 @@ namespace HardwareMonitorTray
             foreach (var sensor in sensors.Take(250))
             {
                 ushort id = (ushort)sensor.Id;
-                sb.AppendLine($"{id:X4}:{sensor.Value:F1}");  // 4-digit hex ID
+                // Zawsze kropka dziesiętna - przy polskiej kulturze F1 dałoby przecinek
+                sb.AppendLine($"{id:X4}:{sensor.Value.ToString("F1", System.Globalization.CultureInfo.InvariantCulture)}");  // 4-digit hex ID
             }
 
             // Simple XOR checksum
@@ -174,29 +885,10 @@ namespace HardwareMonitorTray
                 checksum ^= (byte)c;
             }
 
-            sb.AppendLine($"$E:{checksum: X2}");
+            sb.AppendLine($"$E:{checksum:X2}");
             return sb.ToString();
         }
 
-        private ushort CalculateCRC16(byte[] data, int offset, int length)
-        {
-            ushort crc = 0xFFFF;
-
-            for (int i = offset; i < offset + length && i < data.Length; i++)
-            {
-                crc ^= data[i];
-                for (int j = 0; j < 8; j++)
-                {
-                    if ((crc & 0x0001) != 0)
-                        crc = (ushort)((crc >> 1) ^ 0xA001);
-                    else
-                        crc = (ushort)(crc >> 1);
-                }
-            }
-
-            return crc;
-        }
-
         public void SendRawData(string data)
         {
             if (_serialPort != null && _serialPort.IsOpen && !string.IsNullOrEmpty(data))
@@ -28,7 +28,16 @@ namespace HardwareMonitorTray
             _config = new ConfigManager();
             _monitor = new HardwareMonitorService();
             _monitor.RefreshIntervalMs = _config.Config.RefreshIntervalMs;
-            _serial = new SerialPortService { Mode = _config.Config.ProtocolMode };
+            _serial = new SerialPortService
+            {
+                Mode = _config.Config.ProtocolMode,
+                KeyframeInterval = _config.Config.KeyframeInterval,
+                Encoding = _config.Config.ValueEncoding,
+                Framing = _config.Config.Framing,
+                SchemaFrames = _config.Config.SchemaFrames,
+                FlowControl = _config.Config.FlowControl,
+                MetadataFrames = _config.Config.MetadataFrames
+            };
             _collector = new SensorDataCollector(_monitor);
             _iconMgr = new TrayIconManager();
 
@@ -158,6 +167,12 @@ namespace HardwareMonitorTray
             {
                 _serial.Connect(_config.Config.ComPort, _config.Config.BaudRate);
                 _serial.Mode = _config.Config.ProtocolMode;
+                _serial.KeyframeInterval = _config.Config.KeyframeInterval;
+                _serial.Encoding = _config.Config.ValueEncoding;
+                _serial.Framing = _config.Config.Framing;
+                _serial.SchemaFrames = _config.Config.SchemaFrames;
+                _serial.FlowControl = _config.Config.FlowControl;
+                _serial.MetadataFrames = _config.Config.MetadataFrames;
                 _sendTimer.Interval = _config.Config.SendIntervalMs;
                 _sendTimer.Start();
 
@@ -205,6 +220,12 @@ namespace HardwareMonitorTray
 
                 _serial.Connect(_config.Config.ComPort, _config.Config.BaudRate);
                 _serial.Mode = _config.Config.ProtocolMode;
+                _serial.KeyframeInterval = _config.Config.KeyframeInterval;
+                _serial.Encoding = _config.Config.ValueEncoding;
+                _serial.Framing = _config.Config.Framing;
+                _serial.SchemaFrames = _config.Config.SchemaFrames;
+                _serial.FlowControl = _config.Config.FlowControl;
+                _serial.MetadataFrames = _config.Config.MetadataFrames;
                 _sendTimer.Start();
 
                 _trayIcon.ShowBalloonTip(2000, "Hardware Monitor", $"Serial restarted on {_config.Config.ComPort}", ToolTipIcon.Info);
@@ -254,6 +275,12 @@ namespace HardwareMonitorTray
                 {
                     _sendTimer.Interval = _config.Config.SendIntervalMs;
                     _serial.Mode = _config.Config.ProtocolMode;
+                    _serial.KeyframeInterval = _config.Config.KeyframeInterval;
+                    _serial.Encoding = _config.Config.ValueEncoding;
+                    _serial.Framing = _config.Config.Framing;
+                    _serial.SchemaFrames = _config.Config.SchemaFrames;
+                    _serial.FlowControl = _config.Config.FlowControl;
+                    _serial.MetadataFrames = _config.Config.MetadataFrames;
                 }
             }
         }
@@ -265,7 +292,8 @@ namespace HardwareMonitorTray
                       $"📤 Sent: {_serial.PacketsSent}\n" +
                       $"❌ Errors: {_serial.PacketsErrors}\n" +
                       $"✅ Success: {_serial.SuccessRate:0.0}%\n\n" +
-                      $"🗺 Mapped Sensors: {mapper.Count}\n\n" +
+                      $"🗺 Mapped Sensors: {mapper.Count}\n" +
+                      $"🎯 MCU Subscribed: {(_serial.SubscribedCount > 0 ? _serial.SubscribedCount.ToString() : "all")}\n\n" +
                       $"🌡 CPU:  {_lastCpuTemp:0.0}°C\n" +
                       $"📊 CPU Load: {_lastCpuLoad: 0.0}%\n" +
                       $"🎮 GPU Load: {_lastGpuLoad:0.0}%";
@@ -0,0 +1,181 @@
+using System.Collections.Generic;
+
+namespace HardwareMonitorTray.Protocol
+{
+    /// <summary>
+    /// Role sensorów - stałe ID z SensorId (CpuTemp, GpuLoad...), które MCU zna z HWMonitor.h.
+    /// Ramka META wiąże rolę z ID nadanym przez SensorIdMapper, więc getCpuTemp() na MCU
+    /// trafia we właściwy sensor.
+    /// </summary>
+    public static class SensorRoles
+    {
+        /// <summary>
+        /// Przypisuje role sensorom w podanej kolejności - każda rola trafia do pierwszego pasującego
+        /// </summary>
+        public static Dictionary<ushort, SensorId> Assign(IEnumerable<(ushort Id, string SensorFullId, SensorIdMapper.SensorMapEntry Entry)> sensors)
+        {
+            var result = new Dictionary<ushort, SensorId>();
+            var used = new HashSet<SensorId>();
+
+            foreach (var (id, sensorFullId, entry) in sensors)
+            {
+                var role = Resolve(sensorFullId, entry);
+                if (role == SensorId.Unknown)
+                    continue;
+
+                // Kolejne wentylatory płyty dostają kolejne numery
+                while (used.Contains(role) && role >= SensorId.MbFan1 && role < SensorId.MbFan4)
+                    role++;
+
+                if (used.Add(role))
+                    result[id] = role;
+            }
+
+            return result;
+        }
+
+        /// <summary>
+        /// Rola pojedynczego sensora na podstawie identyfikatora OHM (/amdcpu/0/temperature/0), typu i nazwy
+        /// </summary>
+        public static SensorId Resolve(string sensorFullId, SensorIdMapper.SensorMapEntry entry)
+        {
+            string name = entry.Name.ToLowerInvariant();
+
+            return HardwareKind(sensorFullId, entry.Hardware) switch
+            {
+                "cpu" => Cpu(entry.Type, name),
+                "gpu" => Gpu(entry.Type, name),
+                "ram" => Ram(entry.Type, name),
+                "disk" => Disk(entry.Type, name),
+                "net" => Net(entry.Type, name),
+                "mb" => Mainboard(entry.Type),
+                "battery" => Battery(entry.Type),
+                _ => SensorId.Unknown
+            };
+        }
+
+        private static string HardwareKind(string sensorFullId, string hardware)
+        {
+            var parts = sensorFullId.Split('/', System.StringSplitOptions.RemoveEmptyEntries);
+            string root = parts.Length > 0 ? parts[0].ToLowerInvariant() : "";
+            string hw = hardware.ToLowerInvariant();
+
+            if (root.Contains("cpu")) return "cpu";
+            if (root.Contains("gpu")) return "gpu";
+            if (root == "ram") return "ram";
+            if (root == "hdd" || root == "nvme" || root == "ssd" || root == "storage") return "disk";
+            if (root == "nic" || root == "network") return "net";
+            if (root == "lpc" || root == "mainboard" || root == "motherboard") return "mb";
+            if (root == "battery") return "battery";
+
+            // Nieznana ścieżka - zgadujemy z nazwy sprzętu
+            if (hw.Contains("ryzen") || hw.Contains("intel core")) return "cpu";
+            if (hw.Contains("nvidia") || hw.Contains("geforce") || hw.Contains("radeon")) return "gpu";
+            return "";
+        }
+
+        private static SensorId Cpu(string type, string name)
+        {
+            switch (type)
+            {
+                case "Temperature":
+                    if (name.Contains("package") || name.Contains("tctl") || name.Contains("tdie") || name == "cpu")
+                        return SensorId.CpuTemp;
+                    if (name.Contains("ccd")) return SensorId.CpuTempCcd;
+                    if (name.Contains("core")) return SensorId.CpuTempCore;
+                    break;
+                case "Load":
+                    if (name.Contains("total")) return SensorId.CpuLoad;
+                    if (name.Contains("core")) return SensorId.CpuLoadCore;
+                    break;
+                case "Clock":
+                    if (name.Contains("core")) return SensorId.CpuClock;
+                    break;
+                case "Power":
+                    if (name.Contains("package")) return SensorId.CpuPower;
+                    if (name.Contains("core")) return SensorId.CpuPowerCore;
+                    break;
+                case "Voltage":
+                    if (name.Contains("core") || name.Contains("vid") || name.Contains("cpu")) return SensorId.CpuVoltage;
+                    break;
+            }
+            return SensorId.Unknown;
+        }
+
+        private static SensorId Gpu(string type, string name)
+        {
+            switch (type)
+            {
+                case "Temperature":
+                    if (name.Contains("hot spot") || name.Contains("hotspot")) return SensorId.GpuHotspot;
+                    if (name.Contains("memory")) return SensorId.GpuMemoryTemp;
+                    if (name.Contains("core") || name.Contains("gpu")) return SensorId.GpuTemp;
+                    break;
+                case "Load":
+                    if (name.Contains("video")) return SensorId.GpuVideoLoad;
+                    if (name.Contains("controller")) break;
+                    if (name.Contains("memory")) return SensorId.GpuMemoryLoad;
+                    if (name.Contains("core") || name.Contains("gpu")) return SensorId.GpuLoad;
+                    break;
+                case "Clock":
+                    if (name.Contains("memory")) return SensorId.GpuMemoryClock;
+                    if (name.Contains("core") || name.Contains("gpu")) return SensorId.GpuClock;
+                    break;
+                case "Power":
+                    return SensorId.GpuPower;
+                case "Fan":
+                    return SensorId.GpuFan;
+            }
+            return SensorId.Unknown;
+        }
+
+        private static SensorId Ram(string type, string name)
+        {
+            if (name.Contains("virtual"))
+                return SensorId.Unknown;
+
+            if (type == "Load") return SensorId.RamLoad;
+            if (type == "Data" && name.Contains("used")) return SensorId.RamUsed;
+            if (type == "Data" && name.Contains("available")) return SensorId.RamAvailable;
+            return SensorId.Unknown;
+        }
+
+        private static SensorId Disk(string type, string name)
+        {
+            if (type == "Temperature") return SensorId.DiskTemp;
+            if (type == "Load" && name.Contains("activity")) return SensorId.DiskLoad;
+            if (type == "Throughput" && name.Contains("read")) return SensorId.DiskRead;
+            if (type == "Throughput" && name.Contains("write")) return SensorId.DiskWrite;
+            return SensorId.Unknown;
+        }
+
+        private static SensorId Net(string type, string name)
+        {
+            if (type == "Throughput" && name.Contains("upload")) return SensorId.NetUpload;
+            if (type == "Throughput" && name.Contains("download")) return SensorId.NetDownload;
+            return SensorId.Unknown;
+        }
+
+        private static SensorId Mainboard(string type)
+        {
+            return type switch
+            {
+                "Temperature" => SensorId.MbTemp,
+                "Fan" => SensorId.MbFan1,
+                "Voltage" => SensorId.MbVoltage,
+                _ => SensorId.Unknown
+            };
+        }
+
+        private static SensorId Battery(string type)
+        {
+            return type switch
+            {
+                "Level" => SensorId.BatteryLevel,
+                "Voltage" => SensorId.BatteryVoltage,
+                "Power" => SensorId.BatteryRate,
+                _ => SensorId.Unknown
+            };
+        }
+    }
+}
@@ -15,6 +15,25 @@ namespace HardwareMonitorTray.Protocol
         Json        // Legacy - full JSON format
     }
 
+    /// <summary>
+    /// Value encoding for protocol v3 frames
+    /// </summary>
+    public enum ValueEncoding
+    {
+        Float32,    // 4 bytes, exact
+        Float16,    // 2 bytes, IEEE 754 half - ~3 significant digits
+        Scaled      // 2 bytes, int16 * per-sensor scale (SCALE frame)
+    }
+
+    /// <summary>
+    /// How binary frames are delimited on the wire
+    /// </summary>
+    public enum Framing
+    {
+        Raw,        // START/END bytes only - MCU resyncs by scanning for 0xAA
+        Cobs        // COBS-stuffed frame + 0x00 - MCU resyncs at the next 0x00
+    }
+
     /// <summary>
     /// Compact sensor data structure
     /// </summary>
@@ -102,11 +121,47 @@ namespace HardwareMonitorTray.Protocol
         public const byte START_BYTE = 0xAA;
         public const byte END_BYTE = 0x55;
         public const byte PROTOCOL_VERSION = 0x02;  // Wersja 2 - 2-bajtowe ID
+        public const byte PROTOCOL_VERSION_DELTA = 0x03;  // Wersja 3 - TYPE + SEQ, ramki delta
+
+        // Typy ramek v3 (młodsze 4 bity TYPE)
+        public const byte FRAME_KEYFRAME = 0x00;  // Wszystkie sensory
+        public const byte FRAME_DELTA = 0x01;     // Tylko zmienione sensory
+        public const byte FRAME_SCALE = 0x02;     // Skala i offset dla wartości int16
+        public const byte FRAME_SCHEMA = 0x03;    // Kolejność ID dla ramek VALUES
+        public const byte FRAME_VALUES = 0x04;    // Same wartości, w kolejności schematu
+        public const int SCALE_RECORDS = 32;      // rekordów na ramkę SCALE - tyle przyjmie każdy HWMonitorT
+
+        // Ramki zwrotne MCU -> PC: [START][VER 0x03][TYPE][SEQ][CREDIT][CRC16][END]
+        public const byte FRAME_ACK = 0x05;       // SEQ = ostatnia odebrana ramka, CREDIT = ile ramek może dojść
+        public const byte FRAME_NACK = 0x06;      // ACK + prośba o keyframe
+        public const int CONTROL_FRAME_SIZE = 8;
+        public const byte FRAME_SUBSCRIBE = 0x07; // [..][SEQ 0][COUNT][ID_HI][ID_LO]... - MCU chce tylko te sensory
+        public const byte STATUS_WANT_META = 0x10; // flaga w TYPE ACK/NACK - MCU nie ma jeszcze metadanych
+        public const byte FRAME_KIND_MASK = 0x0F;
+
+        // Metadane PC -> MCU: [ID_HI][ID_LO][ROLE][UNIT x5][NAME x16], napisy UTF-8 dopełnione zerami
+        public const byte FRAME_META = 0x08;
+        public const byte META_RESET = 0x10;      // pierwsza ramka zestawu - MCU czyści stare metadane
+        public const int META_UNIT_SIZE = 5;
+        public const int META_NAME_SIZE = 16;
+        public const int META_RECORD_SIZE = 3 + META_UNIT_SIZE + META_NAME_SIZE;
+        public const int META_RECORDS = 8;        // rekordów na ramkę - tyle przyjmie każdy HWMonitorT
+
+        // Kodowanie wartości v3 (starsze 4 bity TYPE)
+        public const byte ENC_FLOAT32 = 0x00;
+        public const byte ENC_FLOAT16 = 0x10;
+        public const byte ENC_INT16 = 0x20;
 
         public const int MAX_SENSORS = 250;
         public const int HEADER_SIZE = 3;   // START + VERSION + LENGTH
+        public const int HEADER_SIZE_V3 = 5;  // START + VERSION + TYPE + SEQ + LENGTH
+        public const int HEADER_SIZE_VALUES = 7;  // nagłówek v3 + HASH schematu (2)
         public const int FOOTER_SIZE = 3;   // CRC16 + END
         public const int SENSOR_SIZE = 6;   // ID(2) + VALUE(4)
+        public const int SENSOR_SIZE_16 = 4;     // ID(2) + VALUE(2) - float16 / int16
+        public const int ID_SIZE = 2;            // rekord SCHEMA, pomijany w ramkach VALUES
+        public const int SCALE_RECORD_SIZE = 10; // ID(2) + SCALE(4) + OFFSET(4)
+        public const byte COBS_DELIMITER = 0x00;  // Koniec ramki COBS, nie występuje wewnątrz
 
         /// <summary>
         /// Creates a binary packet from sensor data
@@ -182,8 +237,32 @@ namespace HardwareMonitorTray.Protocol
             return sb.ToString();
         }
 
+        private static readonly ushort[] Crc16Table = BuildCrc16Table();
+
+        private static ushort[] BuildCrc16Table()
+        {
+            var table = new ushort[256];
+
+            for (int i = 0; i < 256; i++)
+            {
+                ushort crc = (ushort)i;
+                for (int j = 0; j < 8; j++)
+                {
+                    if ((crc & 0x0001) != 0)
+                        crc = (ushort)((crc >> 1) ^ 0xA001);
+                    else
+                        crc >>= 1;
+                }
+                table[i] = crc;
+            }
+
+            return table;
+        }
+
         /// <summary>
-        /// CRC-16-CCITT calculation
+        /// CRC-16/MODBUS calculation (poly 0xA001 reflected, init 0xFFFF).
+        /// Same table-driven CRC as HWMonitor on the MCU: computed over
+        /// VERSION..last data byte and sent low byte first.
         /// </summary>
         public static ushort CalculateCRC16(byte[] data, int offset, int length)
         {
@@ -191,18 +270,156 @@ namespace HardwareMonitorTray.Protocol
 
             for (int i = offset; i < offset + length && i < data.Length; i++)
             {
-                crc ^= (ushort)(data[i] << 8);
+                crc = (ushort)((crc >> 8) ^ Crc16Table[(crc ^ data[i]) & 0xFF]);
+            }
 
-                for (int j = 0; j < 8; j++)
+            return crc;
+        }
+
+        /// <summary>
+        /// Koduje ramkę COBS w jednym przejściu i dopisuje separator 0x00.
+        /// Narzut: 1 bajt na każde 254 bajty danych + separator.
+        /// </summary>
+        public static byte[] CobsEncode(byte[] data)
+        {
+            byte[] output = new byte[data.Length + data.Length / 254 + 2];
+            int code = 0;   // pozycja bajtu długości bieżącego bloku
+            int idx = 1;
+            byte run = 1;
+
+            foreach (byte b in data)
+            {
+                if (b == 0)
                 {
-                    if ((crc & 0x8000) != 0)
-                        crc = (ushort)((crc << 1) ^ 0x1021);
-                    else
-                        crc <<= 1;
+                    output[code] = run;
+                    code = idx++;
+                    run = 1;
+                    continue;
+                }
+
+                output[idx++] = b;
+                if (++run == 0xFF)
+                {
+                    // Pełny blok 254 bajtów - bez domyślnego zera
+                    output[code] = run;
+                    code = idx++;
+                    run = 1;
                 }
             }
 
-            return crc;
+            output[code] = run;
+            output[idx++] = COBS_DELIMITER;
+
+            Array.Resize(ref output, idx);
+            return output;
+        }
+
+        /// <summary>
+        /// Dekoduje ramkę COBS (bez separatora) w jednym przejściu. Zwraca null dla błędnych danych.
+        /// </summary>
+        public static byte[] CobsDecode(byte[] data, int offset, int length)
+        {
+            byte[] output = new byte[length];
+            int idx = 0;
+            int end = offset + length;
+
+            while (offset < end)
+            {
+                byte code = data[offset++];
+                int run = code - 1;
+
+                if (code == 0 || run > end - offset)
+                    return null;
+
+                Array.Copy(data, offset, output, idx, run);
+                offset += run;
+                idx += run;
+
+                if (code != 0xFF && offset < end)
+                    output[idx++] = 0;
+            }
+
+            Array.Resize(ref output, idx);
+            return output;
+        }
+
+        /// <summary>
+        /// Długość ramki zwrotnej od MCU zaczynającej się w offset:
+        /// 0 - za mało bajtów, -1 - to nie jest ramka zwrotna
+        /// </summary>
+        public static int ControlFrameLength(byte[] data, int offset, int length)
+        {
+            if (length < 3)
+                return 0;
+
+            if (data[offset] != START_BYTE || data[offset + 1] != PROTOCOL_VERSION_DELTA)
+                return -1;
+
+            switch (data[offset + 2] & FRAME_KIND_MASK)
+            {
+                case FRAME_ACK:
+                case FRAME_NACK:
+                    return CONTROL_FRAME_SIZE;
+                case FRAME_SUBSCRIBE:
+                    return length < HEADER_SIZE_V3 ? 0 : HEADER_SIZE_V3 + data[offset + 4] * ID_SIZE + 3;
+                default:
+                    return -1;
+            }
+        }
+
+        /// <summary>
+        /// Sprawdza ramkę SUBSCRIBE z MCU. Pusta lista = wysyłaj wszystko.
+        /// </summary>
+        public static bool TryParseSubscribeFrame(byte[] data, int offset, out ushort[] ids)
+        {
+            ids = null;
+
+            if (offset + HEADER_SIZE_V3 > data.Length || data[offset + 2] != FRAME_SUBSCRIBE)
+                return false;
+
+            int count = data[offset + 4];
+            int crcPos = offset + HEADER_SIZE_V3 + count * ID_SIZE;
+            if (crcPos + 3 > data.Length || data[crcPos + 2] != END_BYTE)
+                return false;
+
+            ushort crc = CalculateCRC16(data, offset + 1, crcPos - offset - 1);
+            if (data[crcPos] != (byte)(crc & 0xFF) || data[crcPos + 1] != (byte)(crc >> 8))
+                return false;
+
+            ids = new ushort[count];
+            for (int i = 0; i < count; i++)
+                ids[i] = (ushort)((data[offset + HEADER_SIZE_V3 + i * 2] << 8) | data[offset + HEADER_SIZE_V3 + i * 2 + 1]);
+
+            return true;
+        }
+
+        /// <summary>
+        /// Sprawdza ramkę zwrotną ACK/NACK z MCU (CRC, stałe bajty)
+        /// </summary>
+        public static bool TryParseControlFrame(byte[] data, int offset, out byte kind, out byte flags, out byte seq, out byte credit)
+        {
+            kind = flags = seq = credit = 0;
+
+            if (offset + CONTROL_FRAME_SIZE > data.Length)
+                return false;
+
+            if (data[offset] != START_BYTE || data[offset + 1] != PROTOCOL_VERSION_DELTA ||
+                data[offset + 7] != END_BYTE)
+                return false;
+
+            byte type = data[offset + 2];
+            if ((type & FRAME_KIND_MASK) != FRAME_ACK && (type & FRAME_KIND_MASK) != FRAME_NACK)
+                return false;
+
+            ushort crc = CalculateCRC16(data, offset + 1, 4);
+            if (data[offset + 5] != (byte)(crc & 0xFF) || data[offset + 6] != (byte)(crc >> 8))
+                return false;
+
+            kind = (byte)(type & FRAME_KIND_MASK);
+            flags = (byte)(type & ~FRAME_KIND_MASK);
+            seq = data[offset + 3];
+            credit = data[offset + 4];
+            return true;
         }
 
         /// <summary>